@@ -0,0 +1,301 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+// Standalone micro-benchmark of the FFT calculation
+// - drives FFTWInstance::calculate() synchronously, without IOC or records
+// - sweeps sizes, window types, output combinations and thread counts
+// - prints the results as JSON on stdout
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dbCommon.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+
+#include "fftwVersion.h"
+#include "fftwConnector.h"
+#include "fftwInstance.h"
+
+namespace {
+
+struct OutputSet
+{
+    const char *name;
+    bool real, magn;
+};
+
+const OutputSet outputSets[] = {
+    {"none", false, false},
+    {"real+imag", true, false},
+    {"magn+phas", false, true},
+    {"all", true, true},
+};
+
+const FFTWCalc::WindowType windowTypes[] = {FFTWCalc::None, FFTWCalc::Hann};
+
+struct Size
+{
+    size_t n;
+    const char *kind;
+};
+
+const Size defaultSizes[] = {
+    {64, "pow2"},      {256, "pow2"},      {1024, "pow2"},      {4096, "pow2"},     {16384, "pow2"},
+    {65536, "pow2"},   {262144, "pow2"},   {1048576, "pow2"},   {1000, "smooth"},   {3600, "smooth"},
+    {10000, "smooth"}, {50000, "smooth"},  {1000000, "smooth"}, {1009, "prime"},    {10007, "prime"},
+    {100003, "prime"}, {1000003, "prime"},
+};
+
+// Connect a connector (with a dummy record) to an instance
+FFTWConnector *
+connect(FFTWInstance *inst, const FFTWConnector::SignalType type)
+{
+    dbCommon *prec = new dbCommon();
+    std::string recname = inst->name + ":" + FFTWConnector::SignalTypeName(type);
+    strncpy(prec->name, recname.c_str(), sizeof(prec->name) - 1);
+
+    FFTWConnector *conn = new FFTWConnector(prec);
+    conn->inst = inst;
+    conn->sigtype = type;
+    if (type == FFTWConnector::InputReal)
+        inst->inputs.push_back(conn);
+    else
+        inst->outputs.push_back(conn);
+    inst->useChannels(conn);
+    return conn;
+}
+
+// One instance with input and all output connectors, fed with a synthetic signal
+struct Bench
+{
+    FFTWInstance *inst;
+    FFTWConnector *input;
+    std::vector<double> data;
+
+    Bench(const std::string &name, const size_t n)
+        : inst(FFTWInstance::findOrCreate(name))
+        , data(n)
+    {
+        input = connect(inst, FFTWConnector::InputReal);
+        inst->triggerSrc = input;
+        connect(inst, FFTWConnector::OutputReal);
+        connect(inst, FFTWConnector::OutputImag);
+        connect(inst, FFTWConnector::OutputMagn);
+        connect(inst, FFTWConnector::OutputPhas);
+
+        srand(42);
+        for (size_t i = 0; i < n; i++)
+            data[i] = sin(0.01 * i) + 0.5 * cos(0.37 * i) + (rand() / (double) RAND_MAX - 0.5) * 0.1;
+    }
+
+    void select(const FFTWCalc::WindowType w, const OutputSet &o)
+    {
+        inst->fftw.set_wtype(w);
+        inst->useReal = inst->useImag = o.real;
+        inst->useMagn = inst->usePhas = o.magn;
+    }
+
+    void run(const size_t reps)
+    {
+        for (size_t i = 0; i < reps; i++) {
+            input->setNextInputValue(data.data(), static_cast<epicsUInt32>(data.size()));
+            inst->calculate();
+        }
+    }
+};
+
+// Estimated memory traffic of one calculation [bytes]
+double
+trafficBytes(const size_t n, const OutputSet &o)
+{
+    const double nfreq = n / 2 + 1;
+    double bytes = 16.0 * n     // input copy into the connector
+                   + 24.0 * n   // window (read input and window, write input)
+                   + 8.0 * n    // transform input
+                   + 16 * nfreq; // transform output
+    if (o.real)
+        bytes += 32.0 * nfreq;
+    if (o.magn)
+        bytes += 32.0 * nfreq;
+    return bytes;
+}
+
+// FFTW convention for the flop count of a real transform
+double
+flops(const size_t n)
+{
+    return 2.5 * n * std::log2(static_cast<double>(n));
+}
+
+size_t
+repetitions(const size_t n, const double points)
+{
+    size_t reps = static_cast<size_t>(points / n);
+    if (reps < 5)
+        reps = 5;
+    if (reps > 100000)
+        reps = 100000;
+    return reps;
+}
+
+struct ThreadRun
+{
+    Bench *bench;
+    size_t reps;
+    epicsEvent *start;
+    epicsEvent done;
+};
+
+void
+threadRun(void *arg)
+{
+    auto run = static_cast<ThreadRun *>(arg);
+    run->start->wait();
+    run->bench->run(run->reps);
+    run->done.signal();
+}
+
+void
+usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog << " [-t max_threads] [-p points_per_run] [-s size[,size...]]\n"
+              << "  -t  largest number of concurrent instances (threads) [4]\n"
+              << "  -p  number of points to transform per run, sets the repetitions [1e7]\n"
+              << "  -s  comma separated list of transform sizes [built-in sweep]" << std::endl;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+    size_t maxThreads = 4;
+    double points = 1e7;
+    std::vector<Size> sizes(std::begin(defaultSizes), std::end(defaultSizes));
+
+    for (int i = 1; i < argc; i++) {
+        std::string opt(argv[i]);
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (opt == "-t") {
+            maxThreads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (opt == "-p") {
+            points = std::strtod(argv[++i], nullptr);
+        } else if (opt == "-s") {
+            sizes.clear();
+            std::istringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ','))
+                sizes.push_back({std::strtoul(item.c_str(), nullptr, 10), "user"});
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::cout << "{\"module\":\"" << EPICS_FFTW_MAJOR_VERSION << "." << EPICS_FFTW_MINOR_VERSION << "."
+              << EPICS_FFTW_MAINTENANCE_VERSION << (EPICS_FFTW_DEVELOPMENT_FLAG ? "-dev" : "")
+              << "\",\"library\":\"" << EPICS_FFTW_LIBRARY_VERSION << "\",\"results\":[";
+    const char *sep = "\n";
+
+    const FFTWStats::Phase phases[] = {
+        FFTWStats::Prepare, FFTWStats::Window, FFTWStats::Execute, FFTWStats::PostProc, FFTWStats::Publish};
+
+    for (const auto &size : sizes) {
+        if (size.n < 2)
+            continue;
+        const size_t reps = repetitions(size.n, points);
+        std::ostringstream name;
+        name << "bench" << size.n;
+        Bench bench(name.str(), size.n);
+
+        // single instance: all windows and output sets
+        for (auto w : windowTypes) {
+            for (const auto &o : outputSets) {
+                bench.select(w, o);
+                bench.run(2); // (re-)plan
+                bench.inst->stats.reset();
+
+                PTimer timer;
+                bench.run(reps);
+                timer.snap();
+                const double per = timer.wall / reps;
+                const double exec = bench.inst->stats.summary(FFTWStats::Execute).mean;
+
+                std::cout << sep << "{\"size\":" << size.n << ",\"kind\":\"" << size.kind << "\",\"window\":\""
+                          << FFTWCalc::WindowTypeName(w) << "\",\"outputs\":\"" << o.name
+                          << "\",\"threads\":1,\"reps\":" << reps << ",\"ns_per_point\":" << per * 1e9 / size.n
+                          << ",\"cpu_ns_per_point\":" << timer.cpu / reps * 1e9 / size.n
+                          << ",\"gflops\":" << (exec > 0.0 ? flops(size.n) / exec * 1e-9 : 0.0)
+                          << ",\"gbytes_per_s\":" << trafficBytes(size.n, o) / per * 1e-9 << ",\"phases_ns\":{";
+                for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+                    FFTWStats::Summary s = bench.inst->stats.summary(phases[p]);
+                    std::cout << (p ? "," : "") << "\"" << FFTWStats::PhaseName(phases[p]) << "\":{\"mean\":"
+                              << s.mean * 1e9 << ",\"p99\":" << s.p99 * 1e9 << "}";
+                }
+                std::cout << "}}";
+                sep = ",\n";
+            }
+        }
+
+        // concurrent instances: Hann window, all outputs
+        std::vector<Bench *> benches(1, &bench);
+        for (size_t threads = 2; threads <= maxThreads; threads *= 2) {
+            while (benches.size() < threads) {
+                std::ostringstream tname;
+                tname << name.str() << "-t" << benches.size();
+                benches.push_back(new Bench(tname.str(), size.n));
+            }
+            for (auto b : benches) {
+                b->select(FFTWCalc::Hann, outputSets[3]);
+                b->run(2);
+            }
+
+            epicsEvent start;
+            std::vector<ThreadRun> runs(threads);
+            for (size_t t = 0; t < threads; t++) {
+                runs[t].bench = benches[t];
+                runs[t].reps = reps;
+                runs[t].start = &start;
+                epicsThreadCreate("fftwBench",
+                                  epicsThreadPriorityMedium,
+                                  epicsThreadGetStackSize(epicsThreadStackMedium),
+                                  threadRun,
+                                  &runs[t]);
+            }
+
+            PTimer timer;
+            for (size_t t = 0; t < threads; t++)
+                start.signal();
+            for (auto &run : runs)
+                run.done.wait();
+            timer.snap();
+            const double per = timer.wall / (reps * threads);
+
+            std::cout << sep << "{\"size\":" << size.n << ",\"kind\":\"" << size.kind
+                      << "\",\"window\":\"Hann\",\"outputs\":\"all\",\"threads\":" << threads << ",\"reps\":" << reps
+                      << ",\"ns_per_point\":" << per * 1e9 / size.n
+                      << ",\"gflops\":" << flops(size.n) / per * 1e-9
+                      << ",\"gbytes_per_s\":" << trafficBytes(size.n, outputSets[3]) / per * 1e-9 << "}";
+        }
+        std::cout.flush();
+    }
+
+    std::cout << "\n]}" << std::endl;
+    return 0;
+}
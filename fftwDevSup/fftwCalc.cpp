@@ -23,24 +23,265 @@
 #include <epicsAssert.h>
 
 #include "fftwCalc.h"
+#include "fftwZoom.h"
 
 int FFTWDebug;
+int FFTWSmallKernels = 1;
 
 // global lock around FFTW planner
 static epicsMutex fftwplanlock;
 
+namespace {
+
+// Fixed-size real transform (N a power of two, 4 <= N <= 64)
+// - window and transform fused, everything on the stack
+// - N/2 point complex radix-2 FFT of the even/odd samples, then split into N/2+1 bins
+// - unnormalized, same result as fftw_plan_dft_r2c_1d()
+template<size_t N>
+class SmallFFT
+{
+    static const size_t M = N / 2;
+    double wr[M], wi[M]; // exp(-2 pi i k / N)
+    size_t rev[M];       // bit reversed index of the complex FFT
+
+public:
+    SmallFFT()
+    {
+        const double PI = 3.141592653589793;
+        size_t bits = 0;
+        while ((size_t(1) << bits) < M)
+            bits++;
+        for (size_t k = 0; k < M; k++) {
+            wr[k] = cos(2.0 * PI * k / N);
+            wi[k] = -sin(2.0 * PI * k / N);
+            rev[k] = 0;
+            for (size_t b = 0; b < bits; b++)
+                if (k & (size_t(1) << b))
+                    rev[k] |= size_t(1) << (bits - 1 - b);
+        }
+    }
+
+    void run(const double *in, const double *win, fftw_complex *out) const
+    {
+        double re[M], im[M];
+
+        for (size_t n = 0; n < M; n++) {
+            re[rev[n]] = in[2 * n] * win[2 * n];
+            im[rev[n]] = in[2 * n + 1] * win[2 * n + 1];
+        }
+
+        for (size_t len = 2; len <= M; len <<= 1) {
+            const size_t half = len / 2;
+            const size_t step = N / len;
+            for (size_t i = 0; i < M; i += len) {
+                for (size_t j = 0; j < half; j++) {
+                    const size_t a = i + j, b = a + half;
+                    const double cr = wr[j * step], ci = wi[j * step];
+                    const double tr = cr * re[b] - ci * im[b];
+                    const double ti = cr * im[b] + ci * re[b];
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+
+        // X[k] = E[k] + W^k O[k], with E/O the spectra of the even/odd samples
+        out[0][0] = re[0] + im[0];
+        out[0][1] = 0.0;
+        out[M][0] = re[0] - im[0];
+        out[M][1] = 0.0;
+        for (size_t k = 1; k < M; k++) {
+            const double er = 0.5 * (re[k] + re[M - k]);
+            const double ei = 0.5 * (im[k] - im[M - k]);
+            const double odr = 0.5 * (im[k] + im[M - k]);
+            const double odi = -0.5 * (re[k] - re[M - k]);
+            out[k][0] = er + wr[k] * odr - wi[k] * odi;
+            out[k][1] = ei + wr[k] * odi + wi[k] * odr;
+        }
+    }
+};
+
+template<size_t N>
+void
+smallTransform(const double *in, const double *win, fftw_complex *out)
+{
+    static const SmallFFT<N> fft;
+    fft.run(in, win, out);
+}
+
+// Frequency of coefficient k of an n point real-to-real transform (normalized to fsamp)
+double
+r2rFreq(const fftw_r2r_kind kind, const size_t k, const size_t n)
+{
+    switch (kind) {
+    case FFTW_REDFT00:
+        return n > 1 ? k / (2.0 * (n - 1)) : 0.0;
+    case FFTW_RODFT00:
+        return (k + 1) / (2.0 * (n + 1));
+    case FFTW_RODFT10:
+        return (k + 1) / (2.0 * n);
+    case FFTW_REDFT01:
+    case FFTW_REDFT11:
+    case FFTW_RODFT01:
+    case FFTW_RODFT11:
+        return (k + 0.5) / (2.0 * n);
+    default:
+        return k / (2.0 * n);
+    }
+}
+
+const fftw_r2r_kind r2rKinds[] = {FFTW_REDFT00,
+                                  FFTW_REDFT10,
+                                  FFTW_REDFT01,
+                                  FFTW_REDFT11,
+                                  FFTW_RODFT00,
+                                  FFTW_RODFT10,
+                                  FFTW_RODFT01,
+                                  FFTW_RODFT11};
+
+} // namespace
+
+const char *
+FFTWCalc::R2rKindName(const fftw_r2r_kind k)
+{
+    switch (k) {
+    case FFTW_REDFT00:
+        return "dct1";
+    case FFTW_REDFT10:
+        return "dct2";
+    case FFTW_REDFT01:
+        return "dct3";
+    case FFTW_REDFT11:
+        return "dct4";
+    case FFTW_RODFT00:
+        return "dst1";
+    case FFTW_RODFT10:
+        return "dst2";
+    case FFTW_RODFT01:
+        return "dst3";
+    case FFTW_RODFT11:
+        return "dst4";
+    default:
+        return "?";
+    }
+}
+
+bool
+FFTWCalc::parseR2rKind(const std::string &name, fftw_r2r_kind &k)
+{
+    for (auto kind : r2rKinds) {
+        if (name == R2rKindName(kind)) {
+            k = kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+fftw_r2r_kind
+FFTWCalc::inverseR2rKind(const fftw_r2r_kind k)
+{
+    switch (k) {
+    case FFTW_REDFT10:
+        return FFTW_REDFT01;
+    case FFTW_REDFT01:
+        return FFTW_REDFT10;
+    case FFTW_RODFT10:
+        return FFTW_RODFT01;
+    case FFTW_RODFT01:
+        return FFTW_RODFT10;
+    default:
+        // types I and IV are their own inverse
+        return k;
+    }
+}
+
+double
+FFTWCalc::r2rNorm(const fftw_r2r_kind k, const size_t n)
+{
+    switch (k) {
+    case FFTW_REDFT00:
+        return 2.0 * (n - 1);
+    case FFTW_RODFT00:
+        return 2.0 * (n + 1);
+    default:
+        return 2.0 * n;
+    }
+}
+
 FFTWCalc::FFTWCalc()
     : wintype(None)
+    , wsum(0.0)
+    , trftype(R2c_1d)
+    , track_freq(false)
+    , track_len(0)
+    , zoom_center(0.0)
+    , zoom_span(0.0)
+    , zoom_bins(0)
+    , r2r_kind(FFTW_REDFT10)
+    , r2r_keep(0)
+    , r2r_inverse(false)
+    , img_rows(0)
+    , img_cols(0)
+    , img_threads(1)
+    , nchan(1)
+    , mem(nullptr)
+    , input(1)
+    , result(nullptr)
     , input_sz(0)
     , ntime(0)
     , nfreq(0)
     , fsamp(0.0)
+    , decimation(1)
+    , mixfreq(0.0)
+    , inplace(false)
+    , small_kernels(-1)
     , redo_plan(true)
+    , redo_window(true)
     , newval(true)
 {}
 
 FFTWCalc::~FFTWCalc() {}
 
+FFTWCalc::SmallKernel
+FFTWCalc::small_kernel() const
+{
+    if (!(small_kernels < 0 ? FFTWSmallKernels : small_kernels) || !batchable())
+        return nullptr;
+    switch (ntime) {
+    case 8:
+        return smallTransform<8>;
+    case 16:
+        return smallTransform<16>;
+    case 32:
+        return smallTransform<32>;
+    case 64:
+        return smallTransform<64>;
+    default:
+        return nullptr;
+    }
+}
+
+void
+FFTWCalc::set_memory(FFTWMemory *m)
+{
+    typedef FFTWAllocator<double> alloc_d;
+    typedef FFTWAllocator<fftw_complex> alloc_c;
+    mem = m;
+    window = std::vector<double, alloc_d>(alloc_d(m));
+    fscale = std::vector<double, alloc_d>(alloc_d(m));
+    inmatrix = std::vector<double, alloc_d>(alloc_d(m));
+    output = std::vector<fftw_complex, alloc_c>(alloc_c(m));
+    iplan.clear();
+    coef = std::vector<double, alloc_d>(alloc_d(m));
+    inverse = std::vector<double, alloc_d>(alloc_d(m));
+    if (zoom)
+        zoom->set_memory(m);
+    redo_plan = redo_window = true;
+}
+
 void
 FFTWCalc::set_fsamp(double f)
 {
@@ -48,6 +289,8 @@ FFTWCalc::set_fsamp(double f)
     if (changed) {
         fsamp = f;
         redo_plan = true; // strictly speaking not needed
+        if (decimation > 1)
+            configure_decimators();
     }
 }
 
@@ -57,42 +300,277 @@ FFTWCalc::set_wtype(FFTWCalc::WindowType type)
     bool changed = wintype != type;
     if (changed) {
         wintype = type;
-        redo_plan = true; // strictly speaking not needed
+        redo_plan = redo_window = true; // strictly speaking only the window
+    }
+}
+
+void
+FFTWCalc::set_nchan(size_t n)
+{
+    if (n != nchan) {
+        nchan = n;
+        input.resize(nchan);
+        if (decimation > 1)
+            configure_decimators();
+        redo_plan = redo_window = true;
+    }
+}
+
+void
+FFTWCalc::set_inplace(bool on)
+{
+    on = on && trftype == R2c_1d;
+    if (on != inplace) {
+        inplace = on;
+        redo_plan = redo_window = true;
+    }
+}
+
+void
+FFTWCalc::set_small_kernels(bool on)
+{
+    small_kernels = on ? 1 : 0;
+}
+
+void
+FFTWCalc::set_transform(TransformType t)
+{
+    if (t != trftype) {
+        trftype = t;
+        nfreq = num_freq();
+        if (t != R2c_1d)
+            inplace = false;
+        redo_plan = redo_window = true;
+    }
+}
+
+size_t
+FFTWCalc::num_freq() const
+{
+    switch (trftype) {
+    case SlidingDFT:
+        return track.size();
+    case Zoom:
+        return zoom_bins;
+    case R2r_1d:
+        return ntime;
+    case R2c_2d:
+        return image_rows() * (image_cols() / 2 + 1);
+    default:
+        return ntime / 2 + 1;
+    }
+}
+
+void
+FFTWCalc::set_zoom(double center, double span, size_t nbins)
+{
+    zoom_center = center;
+    zoom_span = span;
+    zoom_bins = nbins;
+    nfreq = num_freq();
+    redo_plan = true;
+}
+
+void
+FFTWCalc::set_tracking(const std::vector<double> &values, bool freq, size_t len)
+{
+    track = values;
+    track_freq = freq;
+    if (len)
+        track_len = len;
+    nfreq = num_freq();
+    redo_plan = true;
+}
+
+void
+FFTWCalc::set_decimation(size_t factor, double fmix)
+{
+    decimation = factor ? factor : 1;
+    mixfreq = fmix;
+    configure_decimators();
+    redo_plan = true;
+}
+
+void
+FFTWCalc::set_order(size_t spr, size_t ppr, double level)
+{
+    order.configure(spr, ppr, level);
+    redo_plan = true;
+}
+
+void
+FFTWCalc::set_r2r(fftw_r2r_kind kind)
+{
+    set_transform(R2r_1d);
+    if (kind != r2r_kind) {
+        r2r_kind = kind;
+        redo_plan = true;
     }
 }
 
 void
-FFTWCalc::set_input_real(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp)
+FFTWCalc::set_r2r_inverse(bool on, size_t keep)
 {
-    input = std::move(inp);
-    newval = true;
+    r2r_inverse = on;
+    r2r_keep = keep;
+    redo_plan = true;
+}
+
+void
+FFTWCalc::set_image(size_t rows, size_t cols)
+{
+    if (rows != img_rows || cols != img_cols) {
+        img_rows = rows;
+        img_cols = cols;
+        nfreq = num_freq();
+        redo_plan = redo_window = true;
+    }
+}
+
+void
+FFTWCalc::set_image_threads(int n)
+{
+    img_threads = n > 0 ? n : 1;
+    redo_plan = true;
+}
+
+size_t
+FFTWCalc::image_rows() const
+{
+    const size_t r = img_rows ? img_rows : (img_cols ? ntime / img_cols : 0);
+    const size_t c = img_cols ? img_cols : (img_rows ? ntime / img_rows : 0);
+    return r && c && r * c <= ntime ? r : 0;
+}
+
+size_t
+FFTWCalc::image_cols() const
+{
+    const size_t r = img_rows ? img_rows : (img_cols ? ntime / img_cols : 0);
+    const size_t c = img_cols ? img_cols : (img_rows ? ntime / img_rows : 0);
+    return r && c && r * c <= ntime ? c : 0;
+}
+
+void
+FFTWCalc::configure_decimators()
+{
+    if (decimation < 2) {
+        decim.clear();
+        return;
+    }
+    decim.resize(nchan);
+    for (auto &d : decim)
+        d.configure(decimation, fsamp > 0.0 ? mixfreq / fsamp : 0.0);
+}
+
+bool
+FFTWCalc::set_input_real(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp, size_t ch)
+{
+    if (ch >= nchan)
+        return false;
+
+    // order tracking: resampled with the tach signal of the same cycle
+    if (trftype == Order) {
+        order_input.resize(nchan);
+        order_input[ch] = std::move(inp);
+        return false;
+    }
+
+    // decimating front-end: a decimated block of fixed size N / D replaces the input
+    if (decimation > 1) {
+        typedef std::vector<double, FFTWAllocator<double>> vec_d;
+        const size_t len = inp->size() / decimation;
+        std::unique_ptr<vec_d> out(new vec_d(len, 0.0, FFTWAllocator<double>(mem)));
+        if (!decim[ch].block(inp->data(), inp->size(), len, out->data()))
+            return false;
+        inp = std::move(out);
+    }
+
+    store_input(std::move(inp), ch);
+    return true;
+}
+
+void
+FFTWCalc::set_tach(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp)
+{
+    order_tach = std::move(inp);
+}
+
+bool
+FFTWCalc::synchronize()
+{
+    if (trftype != Order)
+        return false;
+
+    // a new tach signal updates the revolutions (the table is kept while their periods don't change)
+    if (order_tach) {
+        order.setTach(order_tach->data(), order_tach->size());
+        order_tach.reset();
+    }
+
+    bool any = false;
+    for (size_t ch = 0; ch < order_input.size() && ch < nchan; ch++) {
+        if (!order_input[ch])
+            continue;
+        std::unique_ptr<std::vector<double, FFTWAllocator<double>>> avg(
+            new std::vector<double, FFTWAllocator<double>>(order.samplesPerRev(), 0.0, FFTWAllocator<double>(mem)));
+        const size_t revs = order.average(order_input[ch]->data(), order_input[ch]->size(), avg->data());
+        order_input[ch].reset();
+        if (!revs)
+            continue;
+        store_input(std::move(avg), ch);
+        any = true;
+    }
+    return any;
+}
+
+void
+FFTWCalc::store_input(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp, size_t ch)
+{
+    // all channels share the size of the latest input
+    const size_t sz = inp->size();
+    input[ch] = std::move(inp);
+    if (ch == 0)
+        newval = true;
 
     // number of time samples
-    ntime = input->size();
-    // number of frequency samples
-    nfreq = ntime / 2 + 1;
+    ntime = sz;
+    // number of frequency samples (sliding DFT, zoom: bins)
+    nfreq = num_freq();
 
     assert(ntime > 0);
-    assert(nfreq > 0);
 
-    if (input_sz != input->size()) {
-        redo_plan = true;
-        input_sz = input->size();
+    if (input_sz != sz) {
+        redo_plan = redo_window = true;
+        input_sz = sz;
     }
 }
 
 static const double PI = 3.141592653589793;
 
 bool
-FFTWCalc::apply_window()
+FFTWCalc::apply_window(double *dst)
 {
     bool window_changed = false;
 
-    if (redo_plan) {
+    if (redo_window) {
+        redo_window = false;
         window_changed = true;
         window.resize(ntime);
         switch (wintype) {
         case Hann: {
+            if (trftype == R2c_2d) {
+                // separable: Hann window over the rows times Hann window over the columns
+                const size_t R = image_rows(), C = image_cols();
+                std::fill(window.begin(), window.end(), 0.0);
+                for (size_t r = 0; r < R; r++) {
+                    const double wr = R > 1 ? sin(PI * r / (R - 1)) : 1.0;
+                    for (size_t c = 0; c < C; c++) {
+                        const double wc = C > 1 ? sin(PI * c / (C - 1)) : 1.0;
+                        window[r * C + c] = wr * wr * wc * wc;
+                    }
+                }
+                break;
+            }
             // Hann window
             assert(ntime > 1);
             double fact = PI / (ntime - 1);
@@ -106,15 +584,51 @@ FFTWCalc::apply_window()
         default:
             std::fill(window.begin(), window.end(), 1.0);
         }
+        wsum = 0.0;
+        for (auto w : window)
+            wsum += w;
+        if (nchan > 1 && !inplace)
+            inmatrix.resize(nchan * ntime);
     }
 
-    if (newval) {
-        // optimization.  Don't use operator[] in a tight loop, it doesn't always get inline'd
-        double *inp = input->data();
-        double *win = window.data();
+    // optimization.  Don't use operator[] in a tight loop, it doesn't always get inline'd
+    double *win = window.data();
+
+    // the sliding DFT runs on the raw samples of channel 0
+    if (trftype == SlidingDFT)
+        return window_changed;
+
+    if (nchan > 1 || inplace) {
+        // window the (raw) inputs into the matrix rows, missing samples are zero
+        const size_t rowlen = inplace ? 2 * nfreq : ntime;
+        for (size_t ch = 0; ch < nchan; ch++) {
+            double *row = inmatrix.data() + ch * rowlen;
+            size_t N = 0;
+            if (input[ch]) {
+                const double *inp = input[ch]->data();
+                N = std::min(input[ch]->size(), ntime);
+                // (in-place: the inputs stay raw, the transform overwrites the rows)
+                for (size_t i = 0; i < N; i++)
+                    row[i] = inp[i] * win[i];
+            }
+            std::fill(row + N, row + ntime, 0.0);
+        }
+        return window_changed;
+    }
 
-        const size_t N = input->size();
+    double *inp = input[0]->data();
+    const size_t N = input[0]->size();
 
+    if (dst) {
+        // newval: input is not windowed yet
+        if (newval) {
+            for (size_t i = 0; i < N; i++)
+                dst[i] = inp[i] * win[i];
+        } else {
+            std::copy(inp, inp + N, dst);
+        }
+    } else if (newval && !small_kernel()) {
+        // (small kernels window on the fly, the input stays raw)
         for (size_t i = 0; i < N; i++)
             inp[i] *= win[i];
 
@@ -125,44 +639,296 @@ FFTWCalc::apply_window()
 }
 
 bool
-FFTWCalc::replan()
+FFTWCalc::replan(bool own_plan)
 {
     bool fscale_changed = false;
 
+    // (batched by a group: the own plan and output are kept for the runs alone)
+    if (own_plan) {
+        const bool planned = trftype == R2c_1d || trftype == Order || trftype == R2r_1d || trftype == R2c_2d;
+        if (small_kernel() ? output.empty() : planned && !plan.get())
+            redo_plan = true;
+        else if (batchable() && !redo_plan)
+            result = output.data(); // back from a batched run
+    }
+
+    if (redo_plan && trftype == SlidingDFT) {
+        // no plan: bins (from frequencies) and the matching scale, the state survives unchanged settings
+        redo_plan = false;
+        fscale_changed = true;
+        const size_t len = track_len ? track_len : ntime;
+        std::vector<double> bins(track);
+        if (track_freq)
+            for (auto &b : bins)
+                b = fsamp > 0.0 ? (b - fbase()) * len / rate() : 0.0;
+        sliding.configure(len, bins);
+        fscale.resize(bins.size());
+        for (size_t i = 0; i < bins.size(); i++)
+            fscale[i] = len ? fbase() + bins[i] * rate() / len : 0.0;
+        // (only channel 0 is tracked, other channels stay zero)
+        output.resize(nchan * bins.size());
+        result = output.empty() ? nullptr : output.data();
+        return fscale_changed;
+    }
+
+    if (redo_plan && trftype == Zoom) {
+        // chirp-z over the band, plans are cached by the zoom object
+        redo_plan = false;
+        fscale_changed = true;
+        const double df = zoom_bins ? zoom_span / zoom_bins : 0.0;
+        const double f0 = zoom_center - zoom_span / 2.0;
+        fscale.resize(zoom_bins);
+        for (size_t i = 0; i < zoom_bins; i++)
+            fscale[i] = f0 + i * df;
+        if (!own_plan || !zoom_bins || fsamp <= 0.0) {
+            output.clear();
+            result = nullptr;
+            return fscale_changed;
+        }
+        if (!zoom) {
+            zoom.reset(new FFTWZoom);
+            zoom->set_memory(mem);
+        }
+        zoom->configure(ntime, (f0 - fbase()) / rate(), df / rate(), zoom_bins);
+        output.resize(nchan * zoom_bins);
+        result = output.data();
+        return fscale_changed;
+    }
+
+    if (redo_plan && trftype == R2r_1d) {
+        // real coefficients instead of the complex result, planned like the r2c transform
+        plan.clear();
+        iplan.clear();
+        output.clear();
+        result = nullptr;
+        redo_plan = false;
+        fscale_changed = true;
+        fscale.resize(ntime);
+        for (size_t i = 0; i < ntime; i++)
+            fscale[i] = fbase() + r2rFreq(r2r_kind, i, ntime) * rate();
+        if (!own_plan || (r2r_kind == FFTW_REDFT00 && ntime < 2))
+            return fscale_changed;
+
+        coef.resize(nchan * ntime);
+        std::unique_ptr<std::vector<double, FFTWAllocator<double>>> buf(
+            new std::vector<double, FFTWAllocator<double>>(FFTWAllocator<double>(mem)));
+        buf->reserve(nchan * ntime);
+        plan = plan_r2r(ntime, nchan, buf->data(), coef.data(), r2r_kind);
+        if (r2r_inverse) {
+            inverse.resize(nchan * ntime);
+            iplan = plan_r2r(ntime, nchan, inverse.data(), inverse.data(), inverseR2rKind(r2r_kind));
+        }
+        return fscale_changed;
+    }
+
     if (redo_plan) {
         // reallocate
         plan.clear(); // free existing plan
-        output.resize(nfreq);
 
         // re-do frequency scale
         fscale_changed = true;
         fscale.resize(nfreq);
-        double mult = fsamp / ntime;
+        if (trftype == R2c_2d) {
+            // 2D: radial spatial frequency of each bin (rows x (cols/2+1), row frequencies wrap)
+            const size_t R = image_rows(), C = image_cols(), F = C / 2 + 1;
+            for (size_t r = 0; r < R; r++) {
+                const double fr = (r <= R / 2 ? double(r) : double(r) - R) / R;
+                for (size_t c = 0; c < F; c++) {
+                    const double fc = double(c) / C;
+                    fscale[r * F + c] = sqrt(fr * fr + fc * fc) * rate();
+                }
+            }
+            redo_plan = false;
+            if (!own_plan)
+                return fscale_changed;
+            output.resize(nchan * nfreq);
+            result = nfreq ? output.data() : nullptr;
+            if (!nfreq)
+                return fscale_changed;
+            std::unique_ptr<std::vector<double, FFTWAllocator<double>>> buf(
+                new std::vector<double, FFTWAllocator<double>>(FFTWAllocator<double>(mem)));
+            buf->reserve(nchan * ntime);
+            plan = plan_2d(R, C, nchan, buf->data(), output.data(), ntime, img_threads);
+            return fscale_changed;
+        }
+        // order tracking: one revolution is transformed, bin i is order i
+        double mult = trftype == Order ? 1.0 : rate() / ntime;
+        double base = trftype == Order ? 0.0 : fbase();
         for (size_t i = 0; i < fscale.size(); i++)
-            fscale[i] = i * mult;
+            fscale[i] = base + i * mult;
+
+        redo_plan = false;
+        if (!own_plan) {
+            // new size while batched: the own output is made for the next run alone
+            output.clear();
+            return fscale_changed;
+        }
 
-        epicsGuard<epicsMutex> pg(fftwplanlock);
+        if (inplace) {
+            // plan on the transform buffer itself, apply_window() fills it afterwards
+            output.clear();
+            output.shrink_to_fit();
+            inmatrix.resize(nchan * 2 * nfreq);
+            result = reinterpret_cast<fftw_complex *>(inmatrix.data());
+            plan = plan_many(ntime, nchan, inmatrix.data(), result, 2 * nfreq);
+            return fscale_changed;
+        }
+
+        output.resize(nchan * nfreq);
+        result = output.data();
+
+        // small sizes: fixed-size kernel, no plan
+        if (small_kernel())
+            return fscale_changed;
 
         // use a junk buffer as planning would overwrite the input
-        std::unique_ptr<std::vector<double, FFTWAllocator<double>>> buf(new std::vector<double, FFTWAllocator<double>>());
-        buf->reserve(input->size());
+        std::unique_ptr<std::vector<double, FFTWAllocator<double>>> buf(
+            new std::vector<double, FFTWAllocator<double>>(FFTWAllocator<double>(mem)));
+        buf->reserve(nchan * ntime);
 
-        // FFTW_EXHAUSTIVE > FFTW_PATIENT > FFTW_MEASURE > FFTW_ESTIMATE
-        plan = fftw_plan_dft_r2c_1d(ntime, buf->data(), output.data(), FFTW_MEASURE);
+        if (nchan > 1) {
+            plan = plan_many(ntime, nchan, buf->data(), output.data());
+        } else {
+            epicsGuard<epicsMutex> pg(fftwplanlock);
 
-        redo_plan = false;
+            // FFTW_EXHAUSTIVE > FFTW_PATIENT > FFTW_MEASURE > FFTW_ESTIMATE
+            plan = fftw_plan_dft_r2c_1d(ntime, buf->data(), output.data(), FFTW_MEASURE);
+        }
     }
     return fscale_changed;
 }
 
+fftw_plan
+FFTWCalc::plan_many(size_t n, size_t howmany, double *in, fftw_complex *out, size_t idist)
+{
+    epicsGuard<epicsMutex> pg(fftwplanlock);
+
+    int rank_n = static_cast<int>(n);
+    int nfreq = rank_n / 2 + 1;
+    return fftw_plan_many_dft_r2c(1,
+                                  &rank_n,
+                                  static_cast<int>(howmany),
+                                  in,
+                                  nullptr,
+                                  1,
+                                  idist ? static_cast<int>(idist) : rank_n,
+                                  out,
+                                  nullptr,
+                                  1,
+                                  nfreq,
+                                  FFTW_MEASURE);
+}
+
+fftw_plan
+FFTWCalc::plan_dft(size_t n, fftw_complex *buf, int sign)
+{
+    epicsGuard<epicsMutex> pg(fftwplanlock);
+    return fftw_plan_dft_1d(static_cast<int>(n), buf, buf, sign, FFTW_MEASURE);
+}
+
+fftw_plan
+FFTWCalc::plan_2d(size_t rows, size_t cols, size_t howmany, double *in, fftw_complex *out, size_t idist, int nthreads)
+{
+    epicsGuard<epicsMutex> pg(fftwplanlock);
+
+#ifdef FFTW_THREADS
+    static const bool threads = fftw_init_threads() != 0;
+    fftw_plan_with_nthreads(threads && nthreads > 1 ? nthreads : 1);
+#else
+    (void) nthreads;
+#endif
+    int n[2] = {static_cast<int>(rows), static_cast<int>(cols)};
+    const int odist = n[0] * (n[1] / 2 + 1);
+    fftw_plan p = fftw_plan_many_dft_r2c(2,
+                                         n,
+                                         static_cast<int>(howmany),
+                                         in,
+                                         nullptr,
+                                         1,
+                                         static_cast<int>(idist),
+                                         out,
+                                         nullptr,
+                                         1,
+                                         odist,
+                                         FFTW_MEASURE);
+#ifdef FFTW_THREADS
+    fftw_plan_with_nthreads(1);
+#endif
+    return p;
+}
+
+fftw_plan
+FFTWCalc::plan_r2r(size_t n, size_t howmany, double *in, double *out, fftw_r2r_kind kind)
+{
+    epicsGuard<epicsMutex> pg(fftwplanlock);
+
+    int rank_n = static_cast<int>(n);
+    return fftw_plan_many_r2r(1,
+                              &rank_n,
+                              static_cast<int>(howmany),
+                              in,
+                              nullptr,
+                              1,
+                              rank_n,
+                              out,
+                              nullptr,
+                              1,
+                              rank_n,
+                              &kind,
+                              FFTW_MEASURE);
+}
+
+fftw_plan
+FFTWCalc::plan_c2r(size_t n, fftw_complex *in, double *out)
+{
+    epicsGuard<epicsMutex> pg(fftwplanlock);
+    return fftw_plan_dft_c2r_1d(static_cast<int>(n), in, out, FFTW_MEASURE);
+}
+
 void
 FFTWCalc::transform()
 {
-    fftw_execute_dft_r2c(plan.get(), input->data(), output.data());
+    if (trftype == SlidingDFT) {
+        // each input block is fed once, a trigger without new input republishes the spectrum
+        if (newval && input[0])
+            sliding.update(input[0]->data(), input[0]->size(), output.data());
+        newval = false;
+    } else if (trftype == Zoom) {
+        for (size_t ch = 0; ch < nchan && result; ch++) {
+            // multi-channel: windowed rows, single channel: windowed in place
+            const double *row = nchan > 1 ? inmatrix.data() + ch * ntime : input[0]->data();
+            zoom->transform(row, result_ch(ch));
+        }
+    } else if (trftype == R2r_1d) {
+        if (!plan.get())
+            return;
+        fftw_execute_r2r(plan.get(), nchan > 1 ? inmatrix.data() : input[0]->data(), coef.data());
+        if (iplan.get()) {
+            // inverse of the first r2r_keep coefficients, normalized
+            const double norm = 1.0 / r2rNorm(r2r_kind, ntime);
+            const size_t keep = r2r_keep && r2r_keep < ntime ? r2r_keep : ntime;
+            for (size_t ch = 0; ch < nchan; ch++) {
+                const double *c = coef.data() + ch * ntime;
+                double *row = inverse.data() + ch * ntime;
+                for (size_t i = 0; i < keep; i++)
+                    row[i] = c[i] * norm;
+                std::fill(row + keep, row + ntime, 0.0);
+            }
+            fftw_execute(iplan.get());
+        }
+    } else if (SmallKernel kernel = small_kernel())
+        kernel(input[0]->data(), window.data(), output.data());
+    else if (inplace)
+        fftw_execute(plan.get());
+    else if (nchan > 1)
+        fftw_execute_dft_r2c(plan.get(), inmatrix.data(), output.data());
+    else
+        fftw_execute_dft_r2c(plan.get(), input[0]->data(), output.data());
 }
 
 #include <epicsExport.h>
 
 extern "C" {
 epicsExportAddress(int, FFTWDebug);
+epicsExportAddress(int, FFTWSmallKernels);
 }
@@ -17,14 +17,24 @@
 
 #include <cstdlib>
 #include <ctime>
+#include <string>
 #include <vector>
 #include <memory>
+#include <type_traits>
 
 #include <fftw3.h>
 
 #include <errlog.h>
 
+#include "fftwDecimator.h"
+#include "fftwMemory.h"
+#include "fftwOrder.h"
+#include "fftwSliding.h"
+
+class FFTWZoom;
+
 extern int FFTWDebug;
+extern int FFTWSmallKernels;
 
 // STL compatible allocator which uses fftw_alloc_*() to ensure aligned arrays
 template<typename T>
@@ -39,7 +49,17 @@ public:
     PTYPE(size_type);
 #undef PTYPE
 
-    inline FFTWAllocator() {}
+    // Byte counter the allocations are accounted to (nullptr = global only)
+    FFTWMemory *acct;
+
+    // Stateful: containers take their allocator along
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+    inline FFTWAllocator(FFTWMemory *acct = nullptr) : acct(acct) {}
+    template<typename U> inline FFTWAllocator(const FFTWAllocator<U> &other) : acct(other.acct) {}
 
     template<typename U> struct rebind {typedef FFTWAllocator<U> other;};
 
@@ -54,15 +74,20 @@ public:
 
     inline pointer allocate(size_type n, const void * =0)
     {
-        return (T*)fftw_malloc(n*sizeof(T));
+        return (T*)FFTWMemory::allocate(n*sizeof(T), acct);
     }
 
     inline void deallocate(pointer p, size_type n)
     {
-        fftw_free(p);
+        FFTWMemory::release(p, n*sizeof(T), acct);
     }
 };
 
+template<typename T, typename U>
+inline bool operator==(const FFTWAllocator<T> &a, const FFTWAllocator<U> &b) {return a.acct == b.acct;}
+template<typename T, typename U>
+inline bool operator!=(const FFTWAllocator<T> &a, const FFTWAllocator<U> &b) {return a.acct != b.acct;}
+
 template<>
 inline void FFTWAllocator<double>::construct(pointer p, const_reference val)
 {::new((void*)p) double(val);}
@@ -127,32 +152,194 @@ struct FFTWCalc
         return "?";
     }
 
+    enum TransformType {
+        R2c_1d = 0,
+        SlidingDFT,
+        Zoom,
+        Order,
+        R2r_1d,
+        R2c_2d,
+    };
+
+    static inline const char *
+    TransformTypeName(const TransformType t)
+    {
+        switch (t) {
+        case R2c_1d:
+            return "r2c";
+        case SlidingDFT:
+            return "sdft";
+        case Zoom:
+            return "zoom";
+        case Order:
+            return "order";
+        case R2r_1d:
+            return "r2r";
+        case R2c_2d:
+            return "r2c2d";
+        }
+        return "?";
+    }
+
+    // Real-to-real kinds by name (dct1..4 = REDFT00, 10, 01, 11, dst1..4 = RODFT00, 10, 01, 11)
+    static const char *R2rKindName(const fftw_r2r_kind k);
+    static bool parseR2rKind(const std::string &name, fftw_r2r_kind &k);
+    // Kind of the inverse and the normalization of the pair (kind, inverse) for n points
+    static fftw_r2r_kind inverseR2rKind(const fftw_r2r_kind k);
+    static double r2rNorm(const fftw_r2r_kind k, const size_t n);
+
     WindowType wintype;
-    std::vector<double> window;
+    std::vector<double, FFTWAllocator<double>> window;
+    double wsum;
+
+    TransformType trftype;
+
+    // Sliding DFT: tracked bins or frequencies [Hz], length (0 = input size)
+    std::vector<double> track;
+    bool track_freq;
+    size_t track_len;
+    FFTWSliding sliding;
+
+    // Zoom: band [Hz] and number of bins, chirp-z transform (created on first use)
+    double zoom_center, zoom_span;
+    size_t zoom_bins;
+    std::unique_ptr<FFTWZoom> zoom;
+
+    // Real-to-real: kind, coefficients and the inverse of the first r2r_keep of them (0 = all),
+    // one row per channel
+    fftw_r2r_kind r2r_kind;
+    size_t r2r_keep;
+    bool r2r_inverse;
+    std::vector<double, FFTWAllocator<double>> coef, inverse;
+    Plan iplan;
 
-    std::unique_ptr<std::vector<double, FFTWAllocator<double>>> input;
+    // 2D: image size (0 = from the input size and the other dimension), planner threads
+    size_t img_rows, img_cols;
+    int img_threads;
+
+    // Order tracking: revolutions of the tach signal, raw inputs and tach waiting for synchronize()
+    FFTWOrder order;
+    std::vector<std::unique_ptr<std::vector<double, FFTWAllocator<double>>>> order_input;
+    std::unique_ptr<std::vector<double, FFTWAllocator<double>>> order_tach;
+
+    // Number of channels (inputs transformed together)
+    size_t nchan;
+
+    // Accounting of the buffers (nullptr = global only)
+    FFTWMemory *mem;
+
+    // Input per channel (single channel: windowed in place)
+    std::vector<std::unique_ptr<std::vector<double, FFTWAllocator<double>>>> input;
+    // Multi-channel: windowed inputs, one row per channel
+    // In-place: transform buffer, one padded row of 2*nfreq per channel
+    std::vector<double, FFTWAllocator<double>> inmatrix;
+    // Output, one row per channel
     std::vector<fftw_complex, FFTWAllocator<fftw_complex>> output;
 
+    // Transform result: own output, or the row of a batched transform
+    fftw_complex *result;
+
     size_t input_sz;
     size_t ntime, nfreq;
 
     Plan plan;
 
     double fsamp;
-    std::vector<double> fscale;
+    std::vector<double, FFTWAllocator<double>> fscale;
+
+    // Decimating front-end per channel: factor (1 = off), mixer frequency [Hz] (0 = no mixer)
+    size_t decimation;
+    double mixfreq;
+    std::vector<FFTWDecimator> decim;
+
+    // Sampling rate of the transform input, frequency of its DC bin
+    double rate() const {return fsamp / decimation;}
+    double fbase() const {return decimation > 1 && mixfreq != 0.0 ? mixfreq - rate() / 4.0 : 0.0;}
+
+    // In-place transform: inputs are windowed into the transform buffer (r2c only)
+    bool inplace;
+
+    // Fixed-size kernels for small transforms: -1 = as FFTWSmallKernels, 0 = off, 1 = on
+    int small_kernels;
 
-    bool redo_plan, newval;
+    bool redo_plan, redo_window, newval;
 
     FFTWCalc();
     ~FFTWCalc();
 
     void set_fsamp(double f);
     void set_wtype(FFTWCalc::WindowType type);
-    void set_input_real(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp);
+    void set_nchan(size_t n);
+    void set_inplace(bool on);
+    void set_small_kernels(bool on);
+    void set_transform(TransformType t);
+    void set_tracking(const std::vector<double> &values, bool freq, size_t len = 0);
+    void set_zoom(double center, double span, size_t nbins);
+    void set_decimation(size_t factor, double fmix);
+    void set_order(size_t spr, size_t ppr, double level);
+    void set_r2r(fftw_r2r_kind kind);
+    void set_r2r_inverse(bool on, size_t keep);
+    void set_image(size_t rows, size_t cols);
+    void set_image_threads(int n);
+    // 2D: image size used for the transform (0 if the input does not fit)
+    size_t image_rows() const;
+    size_t image_cols() const;
+    // Number of output bins of the transform type
+    size_t num_freq() const;
+    // false if the input is not (yet) the transform input
+    // (channel out of range, decimator waiting for samples, order tracking: kept for synchronize())
+    bool set_input_real(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp, size_t ch = 0);
+    void set_tach(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp);
+    // Order tracking: time-synchronous averages of the new raw inputs become the transform inputs
+    // (false: no new input)
+    bool synchronize();
 
-    bool apply_window();
-    bool replan();
+    bool has_input() const
+    {
+        for (auto &inp : input)
+            if (inp)
+                return true;
+        return false;
+    }
+    fftw_complex *result_ch(size_t ch) const {return result + ch * nfreq;}
+    // Sum of the window applied to the transform input (coherent gain)
+    double window_sum() const {return trftype == SlidingDFT ? sliding.length() : wsum;}
+    // Single-channel FFTW transform that a group can batch
+    bool batchable() const {return nchan == 1 && !inplace && trftype == R2c_1d;}
+
+    // Apply window in place, or write windowed input to dst
+    // (in-place transform: into the transform buffer, call after replan())
+    bool apply_window(double *dst = nullptr);
+    // Without own_plan, the result is provided by a batched transform
+    bool replan(bool own_plan = true);
     void transform();
+
+    // Fixed-size kernel (window and transform) used instead of FFTW, nullptr if none
+    typedef void (*SmallKernel)(const double *in, const double *win, fftw_complex *out);
+    SmallKernel small_kernel() const;
+
+    // Account all buffers to an instance
+    void set_memory(FFTWMemory *m);
+
+    // Set up the decimators of all channels (mixer normalized to fsamp)
+    void configure_decimators();
+
+    // Store a transform input (all channels share the size of the latest input)
+    void store_input(std::unique_ptr<std::vector<double, FFTWAllocator<double>>> inp, size_t ch);
+
+    // Create a plan for howmany contiguous transforms of size n (planner overwrites in)
+    // idist: distance between input rows (0 = n)
+    static fftw_plan plan_many(size_t n, size_t howmany, double *in, fftw_complex *out, size_t idist = 0);
+    // Create an in-place complex plan of size n (sign FFTW_FORWARD/FFTW_BACKWARD)
+    static fftw_plan plan_dft(size_t n, fftw_complex *buf, int sign);
+    // Create a plan for howmany 2D transforms of rows x cols, input rows idist apart
+    // (nthreads > 1: multi-threaded, if built with FFTW_THREADS)
+    static fftw_plan plan_2d(size_t rows, size_t cols, size_t howmany, double *in, fftw_complex *out, size_t idist,
+                             int nthreads);
+    // Create a plan for howmany contiguous real-to-real transforms of size n (planner overwrites in and out)
+    static fftw_plan plan_r2r(size_t n, size_t howmany, double *in, double *out, fftw_r2r_kind kind);
+    // Create a complex-to-real plan of size n (planner overwrites in and out)
+    static fftw_plan plan_c2r(size_t n, fftw_complex *in, double *out);
 };
 
 #endif // FFTWCALC_H
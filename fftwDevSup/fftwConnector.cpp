@@ -30,7 +30,19 @@ FFTWConnector::FFTWConnector(dbCommon *prec)
     : inst(nullptr)
     , prec(prec)
     , sigtype(None)
+    , statPhase(FFTWStats::Execute)
+    , statKind(FFTWStats::Mean)
+    , peakQuantity(FFTWPeaks::Freq)
+    , harmFigure(FFTWPeaks::THD)
+    , crossQuantity(FFTWCross::Coherence)
+    , analyticQuantity(FFTWHilbert::Envelope)
+    , profileKind(FFTWProfile::Radial)
+    , next_inp(1)
+    , dimension(0)
     , offset(0)
+    , reqSize(0)
+    , chan(0)
+    , nchan(1)
 {}
 
 long
@@ -42,6 +54,17 @@ FFTWConnector::get_ioint(int cmd, dbCommon *prec, IOSCANPVT *io)
     case OutputMagn:
     case OutputPhas:
     case ExecutionTime:
+    case Statistic:
+    case StatisticHist:
+    case OutputPeak:
+    case Harmonics:
+    case OutputCross:
+    case OutputCorr:
+    case CorrDelay:
+    case OutputAnalytic:
+    case OutputCoef:
+    case OutputInverse:
+    case OutputProfile:
         *io = inst->valueScan;
         return 0;
     case OutputFscale:
@@ -65,28 +88,50 @@ FFTWConnector::show(const unsigned int verbosity, const unsigned char indent) co
               << std::right << prec->name;
     if (offset)
         std::cout << " offset=" << offset;
+    if (sigtype == Statistic || sigtype == StatisticHist)
+        std::cout << " " << FFTWStats::PhaseName(statPhase) << "-" << FFTWStats::KindName(statKind);
+    if (sigtype == OutputPeak)
+        std::cout << " " << FFTWPeaks::QuantityName(peakQuantity);
+    if (sigtype == Harmonics)
+        std::cout << " " << FFTWPeaks::FigureName(harmFigure);
+    if (sigtype == OutputCross)
+        std::cout << " " << FFTWCross::QuantityName(crossQuantity);
+    if (sigtype == OutputAnalytic)
+        std::cout << " " << FFTWHilbert::QuantityName(analyticQuantity);
+    if (sigtype == OutputProfile)
+        std::cout << " " << FFTWProfile::KindName(profileKind);
+    if (reduce)
+        std::cout << " reduce=" << reduce->spec();
+    if (chan || nchan > 1)
+        std::cout << " ch=" << chan;
+    if (nchan > 1)
+        std::cout << ".." << chan + nchan - 1;
 }
 
 void
 FFTWConnector::setRequiredOutputSize(const epicsUInt32 nelm)
 {
-    inst->setRequiredOutputSize(sigtype, nelm + offset);
+    reqSize = nelm + offset;
+    // reduced outputs get their own arrays
+    if (!reduce)
+        inst->setRequiredOutputSize(sigtype, nelm + offset);
 }
 
 void
-FFTWConnector::setNextInputValue(void *bptr, epicsUInt32 elements)
+FFTWConnector::setNextInputValue(void *bptr, epicsUInt32 elements, const size_t index)
 {
-    std::unique_ptr<std::vector<double, FFTWAllocator<double>>> vec(new std::vector<double, FFTWAllocator<double>>());
+    std::unique_ptr<std::vector<double, FFTWAllocator<double>>> vec(
+        new std::vector<double, FFTWAllocator<double>>(FFTWAllocator<double>(&inst->mem)));
 
     const double *src = static_cast<double *>(bptr);
     vec->insert(vec->end(), src, src + elements);
-    next_inp = std::move(vec);
+    next_inp[index] = std::move(vec);
 }
 
 std::unique_ptr<std::vector<double, FFTWAllocator<double>>>
-FFTWConnector::getNextInputValue()
+FFTWConnector::getNextInputValue(const size_t index)
 {
-    return std::move(next_inp);
+    return std::move(next_inp[index]);
 }
 
 void
@@ -131,6 +176,20 @@ double FFTWConnector::getSampleFreq()
     return fsample;
 }
 
+void
+FFTWConnector::setDimension(const size_t n)
+{
+    Guard G(lock);
+    dimension = n;
+}
+
+size_t
+FFTWConnector::getDimension()
+{
+    Guard G(lock);
+    return dimension;
+}
+
 void
 FFTWConnector::setWindowType(const FFTWCalc::WindowType t)
 {
@@ -150,6 +209,14 @@ FFTWConnector::setOffset(const size_t offset)
     this->offset = offset;
 }
 
+void
+FFTWConnector::setChannel(const size_t chan, const size_t count)
+{
+    this->chan = chan;
+    nchan = count;
+    next_inp.resize(count);
+}
+
 FFTWCalc::WindowType FFTWConnector::getWindowType()
 {
     Guard G(lock);
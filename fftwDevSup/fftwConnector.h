@@ -25,6 +25,12 @@
 #include <epicsTime.h>
 
 #include "fftwCalc.h"
+#include "fftwCross.h"
+#include "fftwHilbert.h"
+#include "fftwProfile.h"
+#include "fftwPeaks.h"
+#include "fftwReduce.h"
+#include "fftwStats.h"
 
 typedef epicsGuard<epicsMutex> Guard;
 typedef epicsGuardRelease<epicsMutex> UnGuard;
@@ -44,17 +50,28 @@ public:
         None = 0,
         SetWindowType,
         SetSampleFreq,
+        SetImageRows,
+        SetImageCols,
         ExecutionTime,
         InputReal,
+        InputTach,
         OutputReal,
         OutputImag,
         OutputMagn,
         OutputPhas,
         OutputFscale,
-        OutputWindow
-    };
-    enum TransformType {
-        R2c_1d = 0,
+        OutputWindow,
+        Statistic,
+        StatisticHist,
+        OutputPeak,
+        Harmonics,
+        OutputCross,
+        OutputCorr,
+        CorrDelay,
+        OutputAnalytic,
+        OutputCoef,
+        OutputInverse,
+        OutputProfile
     };
 
     static inline const char *
@@ -67,10 +84,16 @@ public:
             return "SetWindowType";
         case SetSampleFreq:
             return "SetSampleFreq";
+        case SetImageRows:
+            return "SetImageRows";
+        case SetImageCols:
+            return "SetImageCols";
         case ExecutionTime:
             return "ExecutionTime";
         case InputReal:
             return "InputReal";
+        case InputTach:
+            return "InputTach";
         case OutputReal:
             return "OutputReal";
         case OutputImag:
@@ -83,6 +106,28 @@ public:
             return "OutputFscale";
         case OutputWindow:
             return "OutputWindow";
+        case Statistic:
+            return "Statistic";
+        case StatisticHist:
+            return "StatisticHist";
+        case OutputPeak:
+            return "OutputPeak";
+        case Harmonics:
+            return "Harmonics";
+        case OutputCross:
+            return "OutputCross";
+        case OutputCorr:
+            return "OutputCorr";
+        case CorrDelay:
+            return "CorrDelay";
+        case OutputAnalytic:
+            return "OutputAnalytic";
+        case OutputCoef:
+            return "OutputCoef";
+        case OutputInverse:
+            return "OutputInverse";
+        case OutputProfile:
+            return "OutputProfile";
         }
         return "<none>";
     }
@@ -92,7 +137,26 @@ public:
     dbCommon *prec;
 
     SignalType sigtype;
-    TransformType trftype;
+
+    // Statistic signals: phase and kind of statistic
+    FFTWStats::Phase statPhase;
+    FFTWStats::Kind statKind;
+
+    // Peak and harmonic analysis signals: quantity and figure
+    FFTWPeaks::Quantity peakQuantity;
+    FFTWPeaks::Figure harmFigure;
+
+    // Two-input signals (reference channel 0, response channel of the connector): quantity
+    FFTWCross::Quantity crossQuantity;
+
+    // Analytic signal (time domain): quantity
+    FFTWHilbert::Quantity analyticQuantity;
+
+    // 2D spectrum profiles: kind
+    FFTWProfile::Kind profileKind;
+
+    // Spectrum reduction of an output array (nullptr = full spectrum)
+    std::unique_ptr<FFTWReduce> reduce;
 
     long get_ioint(int cmd, dbCommon *prec, IOSCANPVT *io);
 
@@ -106,8 +170,8 @@ public:
     //     called from record processing
     //     holds record lock
 
-    // Copy value into connector (next)
-    void setNextInputValue(void *bptr, epicsUInt32 nelm);
+    // Copy value into connector (next), index selects one of the connector's channels
+    void setNextInputValue(void *bptr, epicsUInt32 nelm, const size_t index = 0);
 
     // Move value from connector into record
     void getNextOutputValue(void **bptr, epicsUInt32 nelm, epicsUInt32 *nord);
@@ -118,6 +182,9 @@ public:
     // Set sampling frequency
     void setSampleFreq(const double f);
 
+    // Set image dimension (rows or columns)
+    void setDimension(const size_t n);
+
     // Set window type
     void setWindowType(const FFTWCalc::WindowType t);
 
@@ -127,10 +194,22 @@ public:
     // Set offset from beginning
     void setOffset(const size_t offset);
 
+    // Size required by the record (including the offset)
+    size_t getRequiredSize() const {return reqSize;}
+
+    // Set channel (first channel and number of channels for inputs)
+    void setChannel(const size_t chan, const size_t count = 1);
+
+    // Get channel
+    size_t getChannel() const {return chan;}
+
+    // Get number of channels
+    size_t getChannelCount() const {return nchan;}
+
     // FFTW instance side interface
 
     // Move value from connector into instance
-    std::unique_ptr<std::vector<double, FFTWAllocator<double>>> getNextInputValue();
+    std::unique_ptr<std::vector<double, FFTWAllocator<double>>> getNextInputValue(const size_t index = 0);
 
     // Move value from instance into connector (next)
     void setNextOutputValue(std::shared_ptr<std::vector<double>> value);
@@ -138,6 +217,9 @@ public:
     // Get the sampling frequency
     double getSampleFreq();
 
+    // Get the image dimension
+    size_t getDimension();
+
     // Get the window type
     FFTWCalc::WindowType getWindowType();
 
@@ -155,11 +237,14 @@ public:
 
 private:
     std::shared_ptr<std::vector<double>> curr_out, next_out;
-    std::unique_ptr<std::vector<double, FFTWAllocator<double>>> next_inp;
+    std::vector<std::unique_ptr<std::vector<double, FFTWAllocator<double>>>> next_inp;
     FFTWCalc::WindowType wintype;
     double fsample;
+    size_t dimension;
     double runtime;
     size_t offset;
+    size_t reqSize;
+    size_t chan, nchan;
     epicsTimeStamp ts;
 };
 
@@ -0,0 +1,115 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+
+#include "fftwCorrelate.h"
+
+FFTWCorrelate::FFTWCorrelate()
+    : n(0)
+    , len(0)
+    , nrows(0)
+    , fresh(false)
+{}
+
+void
+FFTWCorrelate::set_memory(FFTWMemory *mem)
+{
+    typedef FFTWAllocator<double> alloc_d;
+    typedef FFTWAllocator<fftw_complex> alloc_c;
+    fwd.clear();
+    bwd.clear();
+    rows = dvector(alloc_d(mem));
+    spec = cvector(alloc_c(mem));
+    prod = cvector(alloc_c(mem));
+    lags = dvector(alloc_d(mem));
+    n = len = nrows = 0;
+    fresh = false;
+}
+
+void
+FFTWCorrelate::load(const double *x, const size_t nsamp, const size_t ch, const size_t nchan)
+{
+    if (ch >= nchan || !nsamp)
+        return;
+
+    if (nsamp != n || nchan != nrows) {
+        n = nsamp;
+        nrows = nchan;
+        size_t l = 1;
+        while (l < 2 * n - 1)
+            l <<= 1;
+        len = l;
+        const size_t nfreq = len / 2 + 1;
+        fwd.clear();
+        bwd.clear();
+        rows.resize(nrows * len);
+        spec.resize(nrows * nfreq);
+        prod.resize(nfreq);
+        lags.resize(len);
+        // (planning overwrites the buffers, the padding is cleared afterwards)
+        fwd = FFTWCalc::plan_many(len, nrows, rows.data(), spec.data());
+        bwd = FFTWCalc::plan_c2r(len, prod.data(), lags.data());
+        std::fill(rows.begin(), rows.end(), 0.0);
+    }
+
+    std::copy(x, x + n, rows.begin() + ch * len);
+    fresh = true;
+}
+
+bool
+FFTWCorrelate::transform()
+{
+    if (!fresh || !fwd.get())
+        return false;
+    fftw_execute(fwd.get());
+    fresh = false;
+    return true;
+}
+
+bool
+FFTWCorrelate::correlate(const size_t ch, double *out)
+{
+    if (ch >= nrows || !bwd.get())
+        return false;
+
+    // conj(X0) Xch, normalized for the unnormalized inverse
+    const size_t nfreq = len / 2 + 1;
+    const fftw_complex *x = spec.data();
+    const fftw_complex *y = spec.data() + ch * nfreq;
+    const double scale = 1.0 / len;
+    for (size_t i = 0; i < nfreq; i++) {
+        prod[i][0] = (x[i][0] * y[i][0] + x[i][1] * y[i][1]) * scale;
+        prod[i][1] = (x[i][0] * y[i][1] - x[i][1] * y[i][0]) * scale;
+    }
+    fftw_execute(bwd.get());
+
+    // negative lags wrap to the end of the padded result
+    std::copy(lags.end() - (n - 1), lags.end(), out);
+    std::copy(lags.begin(), lags.begin() + n, out + n - 1);
+    return true;
+}
+
+double
+FFTWCorrelate::peakLag(const double *r, const size_t size)
+{
+    if (!size)
+        return 0.0;
+    const size_t k = std::max_element(r, r + size) - r;
+    double delta = 0.0;
+    if (k > 0 && k + 1 < size) {
+        const double a = r[k - 1], b = r[k], c = r[k + 1];
+        const double d = a - 2.0 * b + c;
+        if (d < 0.0)
+            delta = 0.5 * (a - c) / d;
+    }
+    // index 0 is the lag -(n-1)
+    return static_cast<double>(k) + delta - static_cast<double>((size - 1) / 2);
+}
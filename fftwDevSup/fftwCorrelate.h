@@ -0,0 +1,66 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWCORRELATE_H
+#define FFTWCORRELATE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <fftw3.h>
+
+#include "fftwCalc.h"
+
+// FFTWCorrelate
+// - auto and cross correlation of the channels of an instance against channel 0
+// - raw inputs zero-padded to the next power of two >= 2n - 1 (no circular wrap)
+// - one batched r2c plan over all channels, conjugate multiply and a c2r plan per output
+// - plans are kept until input size or number of channels change
+
+class FFTWCorrelate
+{
+public:
+    FFTWCorrelate();
+
+    // Account all buffers to an instance
+    void set_memory(FFTWMemory *m);
+
+    // Copy a new input (n samples) of channel ch (of nchan) into its zero-padded row
+    void load(const double *x, const size_t n, const size_t ch, const size_t nchan);
+
+    // Transform the rows that were loaded since the last call, false if nothing new
+    bool transform();
+
+    // Correlation sum_i x0[i] xch[i + k] for the lags k = -(n-1) .. n-1 (2n - 1 values)
+    bool correlate(const size_t ch, double *out);
+
+    // Lag [samples] of the maximum of a correlation, parabolic interpolation
+    static double peakLag(const double *r, const size_t size);
+
+    size_t size() const {return n ? 2 * n - 1 : 0;}
+    size_t transformSize() const {return len;}
+
+private:
+    typedef std::vector<double, FFTWAllocator<double>> dvector;
+    typedef std::vector<fftw_complex, FFTWAllocator<fftw_complex>> cvector;
+
+    size_t n, len, nrows;
+    bool fresh;
+
+    // Zero-padded inputs and their spectra, one row per channel
+    dvector rows;
+    cvector spec;
+    // Cross spectrum and correlation (c2r scratch)
+    cvector prod;
+    dvector lags;
+    Plan fwd, bwd;
+};
+
+#endif // FFTWCORRELATE_H
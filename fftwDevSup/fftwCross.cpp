@@ -0,0 +1,100 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <cmath>
+
+#include "fftwCross.h"
+#include "fftwNames.h"
+
+bool
+FFTWCross::parse(const std::string &name, Quantity &q)
+{
+    return parseName(name, NQuantities, QuantityName, q);
+}
+
+FFTWCross::FFTWCross()
+    : count(0)
+{}
+
+void
+FFTWCross::reset()
+{
+    count = 0;
+    gxx.clear();
+    gyy.clear();
+    gxyr.clear();
+    gxyi.clear();
+}
+
+void
+FFTWCross::add(const fftw_complex *x, const fftw_complex *y, const size_t n, const size_t navg)
+{
+    if (n != gxx.size()) {
+        reset();
+        gxx.resize(n);
+        gyy.resize(n);
+        gxyr.resize(n);
+        gxyi.resize(n);
+    }
+    if (count < navg)
+        count++;
+    // weight of the new frame: 1/k while filling, then 1/navg
+    const double a = 1.0 / (count ? count : 1);
+    const double b = 1.0 - a;
+
+    double *pxx = gxx.data(), *pyy = gyy.data(), *pr = gxyr.data(), *pi = gxyi.data();
+    for (size_t i = 0; i < n; i++) {
+        const double xr = x[i][0], xi = x[i][1];
+        const double yr = y[i][0], yi = y[i][1];
+        pxx[i] = b * pxx[i] + a * (xr * xr + xi * xi);
+        pyy[i] = b * pyy[i] + a * (yr * yr + yi * yi);
+        // conj(X) Y
+        pr[i] = b * pr[i] + a * (xr * yr + xi * yi);
+        pi[i] = b * pi[i] + a * (xr * yi - xi * yr);
+    }
+}
+
+void
+FFTWCross::get(const Quantity q, double *out) const
+{
+    const size_t n = gxx.size();
+    const double *pxx = gxx.data(), *pyy = gyy.data(), *pr = gxyr.data(), *pi = gxyi.data();
+    switch (q) {
+    case XMagn:
+        for (size_t i = 0; i < n; i++)
+            out[i] = sqrt(pr[i] * pr[i] + pi[i] * pi[i]);
+        break;
+    case XPhas:
+    case H1Phas:
+    case H2Phas:
+        // Gxx and Gyy are real: H1 = Gxy / Gxx and H2 = Gyy / conj(Gxy) have the phase of Gxy
+        for (size_t i = 0; i < n; i++)
+            out[i] = atan2(pi[i], pr[i]);
+        break;
+    case Coherence:
+        for (size_t i = 0; i < n; i++) {
+            const double d = pxx[i] * pyy[i];
+            out[i] = d > 0.0 ? (pr[i] * pr[i] + pi[i] * pi[i]) / d : 0.0;
+        }
+        break;
+    case H1Magn:
+        for (size_t i = 0; i < n; i++)
+            out[i] = pxx[i] > 0.0 ? sqrt(pr[i] * pr[i] + pi[i] * pi[i]) / pxx[i] : 0.0;
+        break;
+    case H2Magn:
+        for (size_t i = 0; i < n; i++) {
+            const double m = sqrt(pr[i] * pr[i] + pi[i] * pi[i]);
+            out[i] = m > 0.0 ? pyy[i] / m : 0.0;
+        }
+        break;
+    case NQuantities:
+        break;
+    }
+}
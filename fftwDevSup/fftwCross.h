@@ -0,0 +1,87 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWCROSS_H
+#define FFTWCROSS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <fftw3.h>
+
+// FFTWCross
+// - averaged auto and cross spectra of a reference (x) and a response (y) channel
+// - cross spectrum, coherence and transfer function estimates H1 = Gxy/Gxx, H2 = Gyy/Gyx
+// - averaging over the last navg frames (running mean, exponential once navg frames are in)
+
+class FFTWCross
+{
+public:
+    enum Quantity {
+        XMagn = 0,
+        XPhas,
+        Coherence,
+        H1Magn,
+        H1Phas,
+        H2Magn,
+        H2Phas,
+        NQuantities
+    };
+
+    static inline const char *
+    QuantityName(const Quantity q)
+    {
+        switch (q) {
+        case XMagn:
+            return "xspec-magn";
+        case XPhas:
+            return "xspec-phas";
+        case Coherence:
+            return "coherence";
+        case H1Magn:
+            return "h1-magn";
+        case H1Phas:
+            return "h1-phas";
+        case H2Magn:
+            return "h2-magn";
+        case H2Phas:
+            return "h2-phas";
+        case NQuantities:
+            break;
+        }
+        return "?";
+    }
+
+    // Parse a quantity name, false if unknown
+    static bool parse(const std::string &name, Quantity &q);
+
+    FFTWCross();
+
+    // Add the spectra of one frame (n bins), restarts the average if n changed
+    void add(const fftw_complex *x, const fftw_complex *y, const size_t n, const size_t navg);
+
+    // Clear the average
+    void reset();
+
+    // Number of frames in the average (up to navg)
+    size_t frames() const {return count;}
+
+    size_t size() const {return gxx.size();}
+
+    // Calculate a quantity (size() values)
+    void get(const Quantity q, double *out) const;
+
+private:
+    size_t count;
+    std::vector<double> gxx, gyy, gxyr, gxyi;
+};
+
+#endif // FFTWCROSS_H
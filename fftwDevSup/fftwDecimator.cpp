@@ -0,0 +1,168 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "fftwDecimator.h"
+
+static const double PI = 3.141592653589793;
+
+namespace {
+
+// Dot product with independent partial sums (lets the compiler vectorize)
+inline double
+dot(const double *a, const double *b, const size_t n)
+{
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++)
+        s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+} // namespace
+
+FFTWDecimator::FFTWDecimator()
+    : d(1)
+    , mixing(false)
+    , next(0)
+    , nout(0)
+    , rr(1.0)
+    , ri(0.0)
+    , sr(1.0)
+    , si(0.0)
+{}
+
+void
+FFTWDecimator::configure(const size_t factor, const double fmix)
+{
+    const bool mix = fmix != 0.0;
+    sr = cos(2.0 * PI * fmix);
+    si = -sin(2.0 * PI * fmix);
+    if (factor == d && mix == mixing && !taps.empty())
+        return;
+
+    d = factor ? factor : 1;
+    mixing = mix;
+
+    // low pass below the output Nyquist frequency (mixer: below fs/4, the band is shifted to fs/4)
+    const size_t ntaps = 32 * d + 1;
+    const double fc = (mixing ? 0.21 : 0.42) / d;
+    const double mid = (ntaps - 1) / 2.0;
+    taps.resize(ntaps);
+    double sum = 0.0;
+    for (size_t i = 0; i < ntaps; i++) {
+        const double t = i - mid;
+        const double sinc = t == 0.0 ? 2.0 * fc : sin(2.0 * PI * fc * t) / (PI * t);
+        // Blackman window
+        const double w = 0.42 - 0.5 * cos(2.0 * PI * i / (ntaps - 1)) + 0.08 * cos(4.0 * PI * i / (ntaps - 1));
+        taps[i] = sinc * w;
+        sum += taps[i];
+    }
+    // unity gain (mixer: the real output carries half of the complex amplitude)
+    const double gain = (mixing ? 2.0 : 1.0) / sum;
+    for (auto &t : taps)
+        t *= gain;
+
+    reset();
+}
+
+void
+FFTWDecimator::reset()
+{
+    wi.assign(taps.size() - 1, 0.0);
+    wq.assign(mixing ? taps.size() - 1 : 0, 0.0);
+    fifo.clear();
+    next = d - 1;
+    nout = 0;
+    rr = 1.0;
+    ri = 0.0;
+}
+
+size_t
+FFTWDecimator::process(const double *x, const size_t n, double *out)
+{
+    const size_t ntaps = taps.size();
+    const size_t hist = ntaps - 1;
+    const double *h = taps.data();
+
+    wi.resize(hist + n);
+    if (mixing) {
+        wq.resize(hist + n);
+        for (size_t i = 0; i < n; i++) {
+            wi[hist + i] = x[i] * rr;
+            wq[hist + i] = x[i] * ri;
+            const double t = rr * sr - ri * si;
+            ri = rr * si + ri * sr;
+            rr = t;
+        }
+        // keep the rotator on the unit circle
+        const double norm = 1.0 / sqrt(rr * rr + ri * ri);
+        rr *= norm;
+        ri *= norm;
+    } else {
+        std::copy(x, x + n, wi.begin() + hist);
+    }
+
+    size_t k = 0;
+    size_t m = next;
+    for (; m < n; m += d, k++) {
+        const double yi = dot(wi.data() + m, h, ntaps);
+        if (!mixing) {
+            out[k] = yi;
+            continue;
+        }
+        // Re(z exp(i pi nout / 2))
+        const double yq = dot(wq.data() + m, h, ntaps);
+        switch (nout++ & 3) {
+        case 0:
+            out[k] = yi;
+            break;
+        case 1:
+            out[k] = -yq;
+            break;
+        case 2:
+            out[k] = -yi;
+            break;
+        default:
+            out[k] = yq;
+        }
+    }
+    next = m - n;
+
+    // keep the history for the next block
+    wi.erase(wi.begin(), wi.begin() + n);
+    if (mixing)
+        wq.erase(wq.begin(), wq.begin() + n);
+    return k;
+}
+
+bool
+FFTWDecimator::block(const double *x, const size_t n, const size_t len, double *out)
+{
+    const size_t have = fifo.size();
+    fifo.resize(have + n / d + 1);
+    fifo.resize(have + process(x, n, fifo.data() + have));
+    if (!len || fifo.size() < len)
+        return false;
+    std::copy(fifo.begin(), fifo.begin() + len, out);
+
+    // (input size not a multiple of the factor: the surplus grows until a sample has to be dropped)
+    const size_t keep = std::min(fifo.size() - len, len - 1);
+    fifo.erase(fifo.begin(), fifo.end() - keep);
+    return true;
+}
@@ -0,0 +1,60 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWDECIMATOR_H
+#define FFTWDECIMATOR_H
+
+#include <cstddef>
+#include <vector>
+
+// FFTWDecimator
+// - decimating front-end of one input channel, state kept across blocks
+// - polyphase FIR (windowed sinc, 32 taps per decimation step), only the kept outputs are calculated
+// - optional NCO mixer: the band around the mixer frequency is shifted to fs/4 of the decimated
+//   (real) output, which covers mixer frequency +/- output rate / 4
+
+class FFTWDecimator
+{
+public:
+    FFTWDecimator();
+
+    // Decimation factor and mixer frequency (normalized to the input rate, 0 = no mixer)
+    // The state is cleared when the factor or the mixer on/off setting changes
+    void configure(const size_t factor, const double fmix);
+
+    // Decimate a block of input samples, the output samples are written to out
+    // (returns their number, at most n / factor + 1)
+    size_t process(const double *x, const size_t n, double *out);
+
+    // Decimate a block of input samples and hand out the next len output samples (fixed transform size),
+    // false while fewer are buffered; at most len-1 samples are kept for the next block (oldest dropped)
+    bool block(const double *x, const size_t n, const size_t len, double *out);
+
+    size_t factor() const {return d;}
+
+private:
+    size_t d;
+    bool mixing;
+    std::vector<double> taps;
+
+    // Work buffers: the last ntaps-1 (mixed) samples followed by the block
+    std::vector<double> wi, wq;
+    // Input index of the next output relative to the block start
+    size_t next;
+    // Output samples not handed out yet
+    std::vector<double> fifo;
+    // Output counter (fs/4 shift) and NCO (rotator and step)
+    size_t nout;
+    double rr, ri, sr, si;
+
+    void reset();
+};
+
+#endif // FFTWDECIMATOR_H
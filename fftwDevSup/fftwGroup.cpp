@@ -0,0 +1,229 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include <epicsGuard.h>
+
+#include "fftwGroup.h"
+#include "fftwInstance.h"
+
+std::vector<FFTWGroup *> FFTWGroup::groups;
+
+FFTWGroup::FFTWGroup(const std::string &name)
+    : name(name)
+    , nready(0)
+    , ntime(0)
+    , nfreq(0)
+    , nBatches(0)
+    , nPartial(0)
+    , nOverrun(0)
+    , nSingle(0)
+{
+    groups.push_back(this);
+}
+
+// Careful: not thread safe (ok during record initialization)
+void
+FFTWGroup::add(FFTWInstance *inst)
+{
+    if (std::find(members.begin(), members.end(), inst) != members.end())
+        return;
+    members.push_back(inst);
+    ready.push_back(false);
+    inst->group = this;
+    ntime = 0; // force replan
+}
+
+void
+FFTWGroup::trigger(FFTWInstance *inst)
+{
+    bool dispatch = false, overrun = false;
+    {
+        Guard G(lock);
+        for (size_t i = 0; i < members.size(); i++) {
+            if (members[i] != inst)
+                continue;
+            if (ready[i]) {
+                // member triggered again before its cycle ran: the earlier data set is replaced,
+                // flush the partial batch
+                nOverrun++;
+                overrun = true;
+                dispatch = true;
+            } else {
+                ready[i] = true;
+                nready++;
+            }
+        }
+        if (nready == members.size())
+            dispatch = true;
+    }
+    if (overrun)
+        inst->sched->coalesced(inst);
+    if (dispatch)
+        members[0]->sched->submit(members[0]);
+}
+
+void
+FFTWGroup::calculate()
+{
+    PTimer runtime;
+    FFTWInstance *leader = members[0];
+
+    std::vector<FFTWInstance *> batch;
+    {
+        Guard G(lock);
+        for (size_t i = 0; i < members.size(); i++) {
+            if (ready[i]) {
+                batch.push_back(members[i]);
+                ready[i] = false;
+            }
+        }
+        nready = 0;
+    }
+    if (batch.size() < members.size())
+        nPartial++;
+
+    // members without any input yet are dropped
+    std::vector<FFTWInstance *> batched, single;
+    size_t n = 0;
+    for (size_t k = 0; k < batch.size(); k++) {
+        FFTWInstance *m = batch[k];
+        m->calctime.start();
+        if (m != leader) {
+            // members are dispatched with the leader
+            m->runTrigtime = leader->runTrigtime;
+            m->stats.add(FFTWStats::QueueWait, leader->qlatLast);
+        }
+        if (!m->fetchInputs())
+            continue;
+        if (!n && m->fftw.batchable())
+            n = m->fftw.ntime;
+        if (m->fftw.batchable() && m->fftw.ntime == n) {
+            batched.push_back(m);
+        } else {
+            single.push_back(m);
+        }
+    }
+
+    if (n && n != ntime) {
+        ntime = n;
+        nfreq = n / 2 + 1;
+        in.resize(members.size() * ntime);
+        out.resize(members.size() * nfreq);
+        plans.clear();
+    }
+    runtime.snap();
+    for (auto m : batched)
+        m->stats.add(FFTWStats::Prepare, runtime);
+
+    // the ready members fill the first rows, only those are transformed
+    Plan *plan = nullptr;
+    if (!batched.empty()) {
+        plan = &plans[batched.size()];
+        if (!plan->get()) {
+            // planning overwrites the buffers, do it before filling them
+            *plan = FFTWCalc::plan_many(ntime, batched.size(), in.data(), out.data());
+        }
+    }
+    runtime.maybeSnap("group calculate() replan", 0.1);
+    // all members see the planning time of the whole batch
+    for (auto m : batched)
+        m->stats.add(FFTWStats::Plan, runtime);
+
+    for (size_t k = 0; k < batched.size(); k++) {
+        FFTWInstance *m = batched[k];
+        PTimer wintime;
+        m->windowChanged = m->fftw.apply_window(in.data() + k * ntime);
+        m->fscaleChanged = m->fftw.replan(false);
+        m->fftw.result = out.data() + k * nfreq;
+        wintime.snap();
+        m->stats.add(FFTWStats::Window, wintime);
+    }
+    runtime.maybeSnap("group calculate() prepare", 5e-3);
+
+    if (!batched.empty()) {
+        FFTWPerf::Sample perf, perfEnd;
+        FFTWPerf::start(perf);
+        fftw_execute(plan->get());
+        FFTWPerf::start(perfEnd);
+        // all members see the counters of the whole batch
+        if (perf.valid && perfEnd.valid)
+            for (auto m : batched)
+                m->perfExec.add(perf, perfEnd);
+        nBatches++;
+    }
+    runtime.maybeSnap("group calculate() execute", 3e-3);
+    // all members see the time of the whole batch
+    for (auto m : batched)
+        m->stats.add(FFTWStats::Execute, runtime);
+
+    for (auto m : batched)
+        m->publish();
+
+    // multi-channel, in-place and members with a different input size are calculated alone
+    for (auto m : single) {
+        nSingle++;
+        runtime.start();
+        if (m->fftw.inplace) {
+            m->fscaleChanged = m->fftw.replan();
+            runtime.snap();
+            m->stats.add(FFTWStats::Plan, runtime);
+        }
+        m->windowChanged = m->fftw.apply_window();
+        runtime.snap();
+        m->stats.add(FFTWStats::Window, runtime);
+        if (!m->fftw.inplace) {
+            m->fscaleChanged = m->fftw.replan();
+            runtime.snap();
+            m->stats.add(FFTWStats::Plan, runtime);
+        }
+        FFTWPerf::Sample perf;
+        FFTWPerf::start(perf);
+        m->fftw.transform();
+        FFTWPerf::stop(perf, m->perfExec);
+        runtime.snap();
+        m->stats.add(FFTWStats::Execute, runtime);
+        m->publish();
+    }
+}
+
+void
+FFTWGroup::show(const unsigned int verbosity) const
+{
+    std::cout << "\nGroup: " << name << " (" << members.size() << " members, leader " << members[0]->name << ")";
+    if (verbosity > 0)
+        std::cout << "\nBatches: " << nBatches << " partial: " << nPartial << " overruns: " << nOverrun
+                  << " calculated alone: " << nSingle;
+    if (verbosity > 1) {
+        std::cout << "\nMembers:";
+        for (auto m : members)
+            std::cout << " " << m->name;
+    }
+}
+
+FFTWGroup *
+FFTWGroup::findOrCreate(const std::string &name)
+{
+    if (FFTWGroup *group = find(name))
+        return group;
+    else
+        return new FFTWGroup(name);
+}
+
+FFTWGroup *
+FFTWGroup::find(const std::string &name)
+{
+    for (auto it : groups)
+        if (it->name == name)
+            return it;
+    return nullptr;
+}
@@ -0,0 +1,71 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWGROUP_H
+#define FFTWGROUP_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <epicsMutex.h>
+
+#include "fftwCalc.h"
+
+class FFTWInstance;
+
+// FFTWGroup
+// - set of instances with identical input size
+// - collects the members triggered in the same cycle
+// - runs one batched transform for all of them, executed by the first member (leader)
+
+class FFTWGroup
+{
+public:
+    std::string name;
+
+    // Add an instance (during record initialization)
+    void add(FFTWInstance *inst);
+
+    // Mark a member as triggered, dispatch the batch when the cycle is complete
+    void trigger(FFTWInstance *inst);
+
+    // Batched calculation, called from the leader's job
+    void calculate();
+
+    // Show method to print the setup
+    void show(const unsigned int verbosity) const;
+
+    // Find a group
+    static FFTWGroup *find(const std::string &name);
+
+    // Factory method to create a group
+    static FFTWGroup *findOrCreate(const std::string &name);
+
+private:
+    FFTWGroup(const std::string &name);
+
+    epicsMutex lock;
+    std::vector<FFTWInstance *> members;
+    std::vector<bool> ready;
+    size_t nready;
+
+    // Batch buffers (one row per member) and plans by number of rows (members ready in a cycle)
+    size_t ntime, nfreq;
+    std::vector<double, FFTWAllocator<double>> in;
+    std::vector<fftw_complex, FFTWAllocator<fftw_complex>> out;
+    std::map<size_t, Plan> plans;
+
+    unsigned long nBatches, nPartial, nOverrun, nSingle;
+
+    static std::vector<FFTWGroup *> groups;
+};
+
+#endif // FFTWGROUP_H
@@ -0,0 +1,131 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "fftwHilbert.h"
+#include "fftwNames.h"
+
+namespace {
+const double PI = 3.141592653589793;
+}
+
+bool
+FFTWHilbert::parse(const std::string &name, Quantity &q)
+{
+    return parseName(name, NQuantities, QuantityName, q);
+}
+
+FFTWHilbert::FFTWHilbert()
+    : n(0)
+    , fresh(false)
+{}
+
+void
+FFTWHilbert::set_memory(FFTWMemory *mem)
+{
+    fwd.clear();
+    bwd.clear();
+    row = dvector(FFTWAllocator<double>(mem));
+    spec = cvector(FFTWAllocator<fftw_complex>(mem));
+    n = 0;
+    fresh = false;
+}
+
+void
+FFTWHilbert::load(const double *x, const size_t nsamp)
+{
+    if (!nsamp)
+        return;
+
+    if (nsamp != n) {
+        n = nsamp;
+        fwd.clear();
+        bwd.clear();
+        row.resize(n);
+        spec.resize(n);
+        // (planning overwrites the buffers)
+        fwd = FFTWCalc::plan_many(n, 1, row.data(), spec.data());
+        bwd = FFTWCalc::plan_dft(n, spec.data(), FFTW_BACKWARD);
+    }
+
+    std::copy(x, x + n, row.begin());
+    fresh = true;
+}
+
+bool
+FFTWHilbert::calculate(const double rate, const double fbase, double *env, double *phas, double *freq)
+{
+    if (!fresh || !fwd.get())
+        return false;
+    fresh = false;
+
+    fftw_execute(fwd.get());
+
+    // double the positive frequencies (DC and Nyquist stay), zero the negative ones,
+    // including the 1/n of the unnormalized inverse
+    const size_t npos = (n + 1) / 2;
+    const double scale = 1.0 / n;
+    spec[0][0] *= scale;
+    spec[0][1] *= scale;
+    for (size_t i = 1; i < npos; i++) {
+        spec[i][0] *= 2.0 * scale;
+        spec[i][1] *= 2.0 * scale;
+    }
+    if (n % 2 == 0) {
+        spec[n / 2][0] *= scale;
+        spec[n / 2][1] *= scale;
+    }
+    for (size_t i = n / 2 + 1; i < n; i++)
+        spec[i][0] = spec[i][1] = 0.0;
+
+    fftw_execute(bwd.get());
+
+    if (env)
+        for (size_t i = 0; i < n; i++)
+            env[i] = sqrt(spec[i][0] * spec[i][0] + spec[i][1] * spec[i][1]);
+
+    if (phas || freq) {
+        // unwrapped phase (into freq's buffer if the phase is not needed)
+        double *ph = phas ? phas : freq;
+        double prev = 0.0, offset = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            const double p = atan2(spec[i][1], spec[i][0]);
+            if (i > 0) {
+                if (p - prev > PI)
+                    offset -= 2.0 * PI;
+                else if (p - prev < -PI)
+                    offset += 2.0 * PI;
+            }
+            prev = p;
+            ph[i] = p + offset;
+        }
+
+        // derivative of the phase, central differences (one-sided at the ends)
+        if (freq) {
+            const double k = rate / (2.0 * PI);
+            if (n < 2) {
+                freq[0] = fbase;
+            } else {
+                double last = ph[0];
+                const double first = (ph[1] - ph[0]) * k + fbase;
+                for (size_t i = 1; i + 1 < n; i++) {
+                    const double cur = ph[i];
+                    freq[i] = 0.5 * (ph[i + 1] - last) * k + fbase;
+                    last = cur;
+                }
+                freq[n - 1] = (ph[n - 1] - last) * k + fbase;
+                freq[0] = first;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWHILBERT_H
+#define FFTWHILBERT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <fftw3.h>
+
+#include "fftwCalc.h"
+
+// FFTWHilbert
+// - analytic signal of one (raw) input channel: r2c, negative frequencies zeroed, inverse complex transform
+// - envelope, unwrapped instantaneous phase and instantaneous frequency (one value per sample)
+// - plans are kept until the input size changes
+
+class FFTWHilbert
+{
+public:
+    enum Quantity {
+        Envelope = 0,
+        Phase,
+        Freq,
+        NQuantities
+    };
+
+    static inline const char *
+    QuantityName(const Quantity q)
+    {
+        switch (q) {
+        case Envelope:
+            return "envelope";
+        case Phase:
+            return "iphase";
+        case Freq:
+            return "ifreq";
+        case NQuantities:
+            break;
+        }
+        return "?";
+    }
+
+    // Parse a quantity name, false if unknown
+    static bool parse(const std::string &name, Quantity &q);
+
+    FFTWHilbert();
+
+    // Account all buffers to an instance
+    void set_memory(FFTWMemory *m);
+
+    // Copy a new input (n samples)
+    void load(const double *x, const size_t n);
+
+    // Calculate the quantities (size() values, nullptr = not needed) from the latest input,
+    // frequency [Hz] at the sampling rate plus an offset, false if there is no new input
+    bool calculate(const double rate, const double fbase, double *env, double *phas, double *freq);
+
+    size_t size() const {return n;}
+
+private:
+    typedef std::vector<double, FFTWAllocator<double>> dvector;
+    typedef std::vector<fftw_complex, FFTWAllocator<fftw_complex>> cvector;
+
+    size_t n;
+    bool fresh;
+
+    // Input, its spectrum (full length, becomes the analytic signal in place)
+    dvector row;
+    cvector spec;
+    Plan fwd, bwd;
+};
+
+#endif // FFTWHILBERT_H
@@ -12,14 +12,22 @@
  *  based on pscdrv/sigApp by Michael Davidsaver <mdavidsaver@ospreydcs.com>
  */
 
+#include <algorithm>
 #include <cmath>
+#include <iomanip>
 #include <iostream>
 
 #include <dbScan.h>
+#include <epicsAtomic.h>
 #include <epicsThread.h>
 
 #include "fftwConnector.h"
+#include "fftwGroup.h"
 #include "fftwInstance.h"
+#include "fftwNuma.h"
+#include "fftwParallel.h"
+#include "fftwTrace.h"
+#include "fftwZoom.h"
 
 // Windows implementation of clock_gettime
 // see: https://stackoverflow.com/questions/5404277/porting-clock-gettime-to-windows
@@ -37,19 +45,10 @@ int clock_gettime(int, struct timespec *spec)      //C-file part
 #endif
 
 std::vector<FFTWInstance *> FFTWInstance::instances;
-FFTWThreadPool FFTWInstance::workers;
-
-FFTWThreadPool::FFTWThreadPool()
-{
-    epicsThreadPoolConfigDefaults(&poolConfig);
-    pool = epicsThreadPoolCreate(&poolConfig);
-    assert(pool != nullptr);
-}
-
-FFTWThreadPool::~FFTWThreadPool()
-{
-    epicsThreadPoolDestroy(pool);
-}
+double FFTWInstance::reportTime = 0.0;
+double FFTWInstance::reportBusy = 0.0;
+epicsMutex FFTWInstance::reportLock;
+FFTWScheduler FFTWInstance::scheduler;
 
 FFTWInstance::FFTWInstance(const std::string &name)
     : name(name)
@@ -68,28 +67,130 @@ FFTWInstance::FFTWInstance(const std::string &name)
     , sizePhas(0)
     , sizeFscale(0)
     , sizeWindow(0)
+    , sizeStatHist(0)
+    , usePeaks(false)
+    , useHarmonics(false)
+    , sizePeak(0)
+    , crossAverage(8)
+    , sizeCross(0)
+    , sizeCorr(0)
+    , sizeAnalytic(0)
+    , useCoef(false)
+    , useInverse(false)
+    , sizeCoef(0)
+    , sizeInverse(0)
+    , sizeProfile(0)
+    , group(nullptr)
+    , numaNode(-1)
+    , sched(&scheduler)
+    , priority(FFTWScheduler::Normal)
+    , deadline(0.0)
+    , skipLate(false)
+    , pending(false)
+    , running(false)
+    , trigtime(0.0)
+    , runTrigtime(0.0)
+    , qlatLast(0.0)
+    , qlatMax(0.0)
+    , qlatSum(0.0)
+    , nRuns(0)
+    , nDeadlineMiss(0)
+    , nSkipped(0)
+    , nCoalesced(0)
+    , nTriggers(0)
+    , createTime(FFTWScheduler::now())
+    , windowChanged(false)
+    , fscaleChanged(false)
+    , reportTriggers(0)
 {
     scanIoInit(&valueScan);
     scanIoInit(&scaleScan);
     scanIoInit(&windowScan);
+    stats.owner = this->name.c_str();
+    fftw.set_memory(&mem);
+    for (int q = 0; q < FFTWHilbert::NQuantities; q++)
+        useAnalytic[q] = false;
+    for (int k = 0; k < FFTWProfile::NKinds; k++)
+        useProfile[k] = false;
     instances.push_back(this);
-    job = epicsJobCreate(workers.pool, calcJob, this);
-    assert(job != nullptr);
 }
 
 void
 FFTWInstance::calculate()
 {
+    if (group) {
+        group->calculate();
+        return;
+    }
+
+    calctime.start();
     PTimer runtime;
 
+    if (!fetchInputs())
+        return;
+    runtime.maybeSnap("calculate() inputs", 1e-3);
+    stats.add(FFTWStats::Prepare, runtime);
+
+    auto window = [&]() {
+        windowChanged = fftw.apply_window();
+        runtime.maybeSnap("calculate() prepare", 5e-3);
+        stats.add(FFTWStats::Window, runtime);
+    };
+    auto replan = [&]() {
+        fscaleChanged = fftw.replan();
+        runtime.maybeSnap("calculate() replan", 0.1);
+        stats.add(FFTWStats::Plan, runtime);
+    };
+    // in-place: planning overwrites the transform buffer, plan before windowing into it
+    if (fftw.inplace) {
+        replan();
+        window();
+    } else {
+        window();
+        replan();
+    }
+
+    FFTWPerf::Sample perf;
+    FFTWPerf::start(perf);
+    fftw.transform();
+    FFTWPerf::stop(perf, perfExec);
+    runtime.maybeSnap("calculate() execute", 3e-3);
+    stats.add(FFTWStats::Execute, runtime);
+
+    publish();
+}
+
+bool
+FFTWInstance::fetchInputs()
+{
     for (auto conn : inputs) {
         switch (conn->sigtype) {
         case FFTWConnector::InputReal:
-            fftw.set_input_real(conn->getNextInputValue());
+            for (size_t i = 0; i < conn->getChannelCount(); i++)
+                if (auto inp = conn->getNextInputValue(i)) {
+                    const size_t ch = conn->getChannel() + i;
+                    // the correlation uses the raw input, before it is windowed
+                    if (!fftw.set_input_real(std::move(inp), ch))
+                        continue;
+                    if (correlator)
+                        correlator->load(fftw.input[ch]->data(), fftw.input[ch]->size(), ch, fftw.nchan);
+                    if (ch < hilbert.size() && hilbert[ch])
+                        hilbert[ch]->load(fftw.input[ch]->data(), fftw.input[ch]->size());
+                }
+            break;
+        case FFTWConnector::InputTach:
+            if (auto inp = conn->getNextInputValue())
+                fftw.set_tach(std::move(inp));
             break;
         case FFTWConnector::SetSampleFreq:
             fftw.set_fsamp(conn->getSampleFreq());
             break;
+        case FFTWConnector::SetImageRows:
+            fftw.set_image(conn->getDimension(), fftw.img_cols);
+            break;
+        case FFTWConnector::SetImageCols:
+            fftw.set_image(fftw.img_rows, conn->getDimension());
+            break;
         case FFTWConnector::SetWindowType:
             fftw.set_wtype(conn->getWindowType());
             break;
@@ -98,19 +199,47 @@ FFTWInstance::calculate()
         }
     }
 
-    epicsTimeStamp ts = triggerSrc->getTimestamp();
+    // order tracking: resample the new inputs with the revolutions of the tach signal
+    fftw.synchronize();
 
-    bool window_changed = fftw.apply_window();
-    runtime.maybeSnap("calculate() prepare", 5e-3);
+    ts = triggerSrc->getTimestamp();
 
-    bool fscale_changed = fftw.replan();
-    runtime.maybeSnap("calculate() replan", 0.1);
+    // nothing to transform before the first input arrived
+    return fftw.has_input();
+}
 
-    fftw.transform();
-    runtime.maybeSnap("calculate() execute", 3e-3);
+std::shared_ptr<std::vector<double>>
+FFTWInstance::reduced(FFTWConnector *conn, const std::shared_ptr<std::vector<double>> &full, const bool rebuild)
+{
+    FFTWReduce *r = conn->reduce.get();
+    if (!r || !full)
+        return full;
+    if (rebuild || r->inputSize() != fftw.fscale.size())
+        r->build(fftw.fscale.data(), fftw.fscale.size());
+    if (full->size() != r->inputSize())
+        return nullptr;
+
+    auto vec = mem.makeVector(r->size(), std::max(r->size(), conn->getRequiredSize()));
+    if (conn->sigtype == FFTWConnector::OutputFscale)
+        std::copy(r->centers().begin(), r->centers().end(), vec->begin());
+    else
+        r->apply(full->data(), vec->data());
+    return vec;
+}
+
+void
+FFTWInstance::publish()
+{
+    PTimer runtime;
+    FFTWPerf::Sample perf;
+    FFTWPerf::start(perf);
+    const bool window_changed = windowChanged;
+    const bool fscale_changed = fscaleChanged;
 
+    // (real-to-real transforms have coefficients instead of a complex result)
+    const bool r2r = fftw.trftype == FFTWCalc::R2r_1d;
     valid = true;
-    if (fftw.output.size() == 0 || fftw.window.size() == 0 || fftw.fscale.size() == 0)
+    if ((r2r ? !fftw.plan.get() : !fftw.result) || fftw.window.size() == 0 || fftw.fscale.size() == 0)
         valid = false;
 
     // Trying to do some optimization while letting the compiler still do vectorization
@@ -119,42 +248,155 @@ FFTWInstance::calculate()
 #define creal(C) C[0]
 #define cimag(C) C[1]
 
-    if (useReal || useImag) {
-        outReal = std::shared_ptr<std::vector<double>>(new std::vector<double>(fftw.nfreq));
-        outReal->reserve(sizeReal);
-        double *outr = outReal->data();
-        outImag = std::shared_ptr<std::vector<double>>(new std::vector<double>(fftw.nfreq));
-        outImag->reserve(sizeImag);
-        double *outi = outImag->data();
-
-        for (size_t i = 0; i < fftw.nfreq; i++) {
-            fftw_complex &out = fftw.output[i];
-            outr[i] = creal(out);
-            outi[i] = cimag(out);
+    outReal.resize(fftw.nchan);
+    outImag.resize(fftw.nchan);
+    outMagn.resize(fftw.nchan);
+    outPhas.resize(fftw.nchan);
+    outPeaks.resize(fftw.nchan);
+    outCoef.resize(fftw.nchan);
+    outInverse.resize(fftw.nchan);
+
+    for (size_t ch = 0; ch < fftw.nchan; ch++) {
+        if (ch >= chanUsed.size() || !chanUsed[ch])
+            continue;
+        // (no result, e.g. a zoom before the sample frequency is set: keep the previous outputs)
+        if (!valid)
+            continue;
+
+        if (r2r) {
+            const size_t n = fftw.ntime;
+            if (useCoef) {
+                outCoef[ch] = mem.makeVector(n, sizeCoef);
+                std::copy(fftw.coef.begin() + ch * n, fftw.coef.begin() + (ch + 1) * n, outCoef[ch]->begin());
+            }
+            if (useInverse && fftw.iplan.get()) {
+                outInverse[ch] = mem.makeVector(n, sizeInverse);
+                std::copy(fftw.inverse.begin() + ch * n, fftw.inverse.begin() + (ch + 1) * n, outInverse[ch]->begin());
+            }
+            continue;
+        }
+        const fftw_complex *res = fftw.result_ch(ch);
+        double *outr = nullptr, *outi = nullptr, *outm = nullptr, *outp = nullptr;
+
+        if (useReal || useImag) {
+            outReal[ch] = mem.makeVector(fftw.nfreq, sizeReal);
+            outr = outReal[ch]->data();
+            outImag[ch] = mem.makeVector(fftw.nfreq, sizeImag);
+            outi = outImag[ch]->data();
+        }
+
+        if (useMagn || usePhas) {
+            outMagn[ch] = mem.makeVector(fftw.nfreq, sizeMagn);
+            outm = outMagn[ch]->data();
+            outPhas[ch] = mem.makeVector(fftw.nfreq, sizePhas);
+            outp = outPhas[ch]->data();
+        }
+
+        // large spectra are split into chunks that run in parallel
+        FFTWParallel::forEach(fftw.nfreq, [=](size_t begin, size_t end) {
+            if (outr) {
+                for (size_t i = begin; i < end; i++) {
+                    const fftw_complex &out = res[i];
+                    outr[i] = creal(out);
+                    outi[i] = cimag(out);
+                }
+            }
+            if (outm) {
+                for (size_t i = begin; i < end; i++) {
+                    const fftw_complex &out = res[i];
+                    outm[i] = 20. * log(sqrt(creal(out) * creal(out) + cimag(out) * cimag(out)));
+                    outp[i] = atan(cimag(out) / creal(out));
+                }
+            }
+        });
+
+        // 2D: profiles of the magnitude image
+        if (fftw.trftype == FFTWCalc::R2c_2d && valid) {
+            const size_t R = fftw.image_rows(), C = fftw.image_cols();
+            for (int k = 0; k < FFTWProfile::NKinds; k++) {
+                if (!useProfile[k])
+                    continue;
+                const FFTWProfile::Kind kind = static_cast<FFTWProfile::Kind>(k);
+                outProfile[k].resize(fftw.nchan);
+                outProfile[k][ch] = mem.makeVector(FFTWProfile::size(kind, R, C), sizeProfile);
+                FFTWProfile::calculate(kind, res, R, C, outProfile[k][ch]->data());
+            }
         }
-    }
 
-    if (useMagn || usePhas) {
-        outMagn = std::shared_ptr<std::vector<double>>(new std::vector<double>(fftw.nfreq));
-        outMagn->reserve(sizeMagn);
-        double *outm = outMagn->data();
-        outPhas = std::shared_ptr<std::vector<double>>(new std::vector<double>(fftw.nfreq));
-        outPhas->reserve(sizePhas);
-        double *outp = outPhas->data();
-
-        for (size_t i = 0; i < fftw.nfreq; i++) {
-            fftw_complex &out = fftw.output[i];
-            outm[i] = 20. * log(sqrt(creal(out) * creal(out) + cimag(out) * cimag(out)));
-            outp[i] = atan(cimag(out) / creal(out));
+        // peaks and harmonics from the same result (small, not worth splitting)
+        if ((usePeaks || useHarmonics) && valid) {
+            FFTWPeaks::Result &pr = outPeaks[ch];
+            for (int q = 0; q < FFTWPeaks::NQuantities; q++)
+                pr.value[q] = mem.makeVector(peaks.npeaks, sizePeak);
+            double fbin = 0.0;
+            const size_t found = peaks.find(res,
+                                            fftw.nfreq,
+                                            fftw.fscale.data(),
+                                            fftw.window_sum(),
+                                            pr.value[FFTWPeaks::Freq]->data(),
+                                            pr.value[FFTWPeaks::Ampl]->data(),
+                                            pr.value[FFTWPeaks::Phas]->data(),
+                                            &fbin);
+            for (int q = 0; q < FFTWPeaks::NQuantities; q++)
+                pr.value[q]->resize(found);
+            pr.figure[FFTWPeaks::Fund] = found ? (*pr.value[FFTWPeaks::Freq])[0] : 0.0;
+            if (useHarmonics && found)
+                peaks.harmonics(res, fftw.nfreq, fbin, pr.figure);
         }
     }
 
 #undef creal
 #undef cimag
 
+    // average the cross spectra of the response channels
+    for (size_t ch = 1; ch < cross.size() && ch < fftw.nchan; ch++)
+        if (cross[ch] && valid && fftw.result)
+            cross[ch]->add(fftw.result_ch(0), fftw.result_ch(ch), fftw.nfreq, crossAverage);
+
+    // correlations, only recalculated when there is new input
+    if (correlator && correlator->transform()) {
+        outCorr.resize(corrUsed.size());
+        corrDelay.resize(corrUsed.size(), 0.0);
+        for (size_t ch = 0; ch < corrUsed.size(); ch++) {
+            if (!corrUsed[ch])
+                continue;
+            auto vec = mem.makeVector(correlator->size(), sizeCorr);
+            if (!correlator->correlate(ch, vec->data()))
+                continue;
+            // (no sample frequency set: 0, like the frequency scale)
+            const double lag = FFTWCorrelate::peakLag(vec->data(), vec->size());
+            corrDelay[ch] = fftw.rate() > 0.0 ? lag / fftw.rate() : 0.0;
+            outCorr[ch] = vec;
+        }
+    }
+
+    // analytic signals, only recalculated when there is new input
+    for (size_t ch = 0; ch < hilbert.size(); ch++) {
+        if (!hilbert[ch])
+            continue;
+        double *out[FFTWHilbert::NQuantities];
+        std::shared_ptr<std::vector<double>> vec[FFTWHilbert::NQuantities];
+        for (int q = 0; q < FFTWHilbert::NQuantities; q++) {
+            out[q] = nullptr;
+            if (useAnalytic[q]) {
+                vec[q] = mem.makeVector(hilbert[ch]->size(), sizeAnalytic);
+                out[q] = vec[q]->data();
+            }
+        }
+        if (hilbert[ch]->calculate(fftw.rate(),
+                                   fftw.fbase(),
+                                   out[FFTWHilbert::Envelope],
+                                   out[FFTWHilbert::Phase],
+                                   out[FFTWHilbert::Freq])) {
+            for (int q = 0; q < FFTWHilbert::NQuantities; q++) {
+                outAnalytic[q].resize(hilbert.size());
+                outAnalytic[q][ch] = vec[q];
+            }
+        }
+    }
+
     if (useWindow && window_changed) {
-        outWindow = std::shared_ptr<std::vector<double>>(new std::vector<double>(fftw.ntime));
-        outWindow->reserve(sizeWindow);
+        outWindow = mem.makeVector(fftw.ntime, sizeWindow);
         double *outw = outWindow->data();
         double *getw = fftw.window.data();
         for (size_t i = 0; i < fftw.ntime; i++)
@@ -162,53 +404,113 @@ FFTWInstance::calculate()
     }
 
     if (useFscale && fscale_changed) {
-        outFscale = std::shared_ptr<std::vector<double>>(new std::vector<double>(fftw.nfreq));
-        outFscale->reserve(sizeFscale);
+        outFscale = mem.makeVector(fftw.nfreq, sizeFscale);
         double *outf = outFscale->data();
         double *getf = fftw.fscale.data();
         for (size_t i = 0; i < fftw.nfreq; i++)
             outf[i] = getf[i];
     }
 
+    FFTWPerf::stop(perf, perfPostProc);
     runtime.maybeSnap("calculate() post-proc", 1e-3);
+    stats.add(FFTWStats::PostProc, runtime);
 
     lasttime = calctime.snap();
     for (auto conn : outputs) {
         conn->setTimestamp(ts);
+        const size_t ch = conn->getChannel();
         switch (conn->sigtype) {
         case FFTWConnector::OutputImag:
-            conn->setNextOutputValue(outImag);
+            if (ch < fftw.nchan)
+                conn->setNextOutputValue(reduced(conn, outImag[ch], fscale_changed));
             break;
         case FFTWConnector::OutputReal:
-            conn->setNextOutputValue(outReal);
+            if (ch < fftw.nchan)
+                conn->setNextOutputValue(reduced(conn, outReal[ch], fscale_changed));
             break;
         case FFTWConnector::OutputMagn:
-            conn->setNextOutputValue(outMagn);
+            if (ch < fftw.nchan)
+                conn->setNextOutputValue(reduced(conn, outMagn[ch], fscale_changed));
             break;
         case FFTWConnector::OutputPhas:
-            conn->setNextOutputValue(outPhas);
+            if (ch < fftw.nchan)
+                conn->setNextOutputValue(reduced(conn, outPhas[ch], fscale_changed));
             break;
         case FFTWConnector::OutputFscale:
             if (fscale_changed)
-                conn->setNextOutputValue(outFscale);
+                conn->setNextOutputValue(reduced(conn, outFscale, fscale_changed));
             break;
         case FFTWConnector::OutputWindow:
             if (window_changed)
                 conn->setNextOutputValue(outWindow);
             break;
+        case FFTWConnector::OutputPeak:
+            if (ch < fftw.nchan && outPeaks[ch].value[conn->peakQuantity])
+                conn->setNextOutputValue(outPeaks[ch].value[conn->peakQuantity]);
+            break;
+        case FFTWConnector::OutputCross:
+            if (ch < cross.size() && cross[ch] && cross[ch]->size() == fftw.nfreq) {
+                auto vec = mem.makeVector(fftw.nfreq, sizeCross);
+                cross[ch]->get(conn->crossQuantity, vec->data());
+                conn->setNextOutputValue(reduced(conn, vec, fscale_changed));
+            }
+            break;
+        case FFTWConnector::OutputProfile:
+            if (ch < outProfile[conn->profileKind].size() && outProfile[conn->profileKind][ch])
+                conn->setNextOutputValue(outProfile[conn->profileKind][ch]);
+            break;
+        case FFTWConnector::OutputCoef:
+            if (ch < outCoef.size() && outCoef[ch])
+                conn->setNextOutputValue(reduced(conn, outCoef[ch], fscale_changed));
+            break;
+        case FFTWConnector::OutputInverse:
+            if (ch < outInverse.size() && outInverse[ch])
+                conn->setNextOutputValue(outInverse[ch]);
+            break;
+        case FFTWConnector::OutputAnalytic:
+            if (ch < outAnalytic[conn->analyticQuantity].size() && outAnalytic[conn->analyticQuantity][ch])
+                conn->setNextOutputValue(outAnalytic[conn->analyticQuantity][ch]);
+            break;
+        case FFTWConnector::OutputCorr:
+            if (ch < outCorr.size() && outCorr[ch])
+                conn->setNextOutputValue(outCorr[ch]);
+            break;
+        case FFTWConnector::CorrDelay:
+            if (ch < corrDelay.size())
+                conn->setRuntime(corrDelay[ch]);
+            break;
+        case FFTWConnector::Harmonics:
+            if (ch < fftw.nchan)
+                conn->setRuntime(outPeaks[ch].figure[conn->harmFigure]);
+            break;
         case FFTWConnector::ExecutionTime:
             conn->setRuntime(lasttime);
             break;
+        case FFTWConnector::Statistic:
+            conn->setRuntime(stats.summary(conn->statPhase).get(conn->statKind));
+            break;
+        case FFTWConnector::StatisticHist: {
+            std::vector<double> h = stats.histogram(conn->statPhase);
+            std::shared_ptr<std::vector<double>> outHist(new std::vector<double>(h.begin(), h.end()));
+            outHist->reserve(sizeStatHist);
+            conn->setNextOutputValue(outHist);
+            break;
+        }
         default:
             break;
         }
     }
 
+    FFTWTrace::instant("scanIoRequest", name.c_str());
     scanIoRequest(valueScan);
     if (fscale_changed)
         scanIoRequest(scaleScan);
     if (window_changed)
         scanIoRequest(windowScan);
+
+    runtime.snap();
+    stats.add(FFTWStats::Publish, runtime);
+    stats.add(FFTWStats::Total, FFTWScheduler::now() - runTrigtime);
 }
 
 void
@@ -216,8 +518,12 @@ FFTWInstance::trigger()
 {
     if (triggerSrc && triggerSrc->prec->tpro > 5)
         std::cerr << "Queueing calculation job for " << name << std::endl;
-    calctime.start();
-    epicsJobQueue(job);
+    FFTWTrace::instant("trigger", name.c_str());
+    epicsAtomicIncrSizeT(&nTriggers);
+    if (group)
+        group->trigger(this);
+    else
+        sched->submit(this);
 }
 
 void
@@ -225,7 +531,7 @@ FFTWInstance::show(const unsigned int verbosity) const
 {
     std::cout << "Instance " << name;
     if (verbosity > 1)
-        std::cout << " using job " << job << " of pool " << workers.pool;
+        std::cout << " using pool " << sched->threadPool();
     std::cout << "\nConnected records:";
     for (auto &conn : inputs)
         conn->show(verbosity, 2);
@@ -250,13 +556,259 @@ FFTWInstance::show(const unsigned int verbosity) const
         std::cout << "\nTriggered by: " << triggerSrc->prec->name;
     else
         std::cout << "\nNo trigger set";
-    std::cout << "\nInput size: " << fftw.input_sz
+    if (group)
+        group->show(verbosity);
+    if (numaNode >= 0)
+        std::cout << "\nNUMA node: " << numaNode;
+    std::cout << "\nInput size: " << fftw.input_sz;
+    if (fftw.nchan > 1)
+        std::cout << " x " << fftw.nchan << " channels";
+    if (fftw.decimation > 1) {
+        std::cout << "\nDecimation: " << fftw.decimation;
+        if (fftw.mixfreq != 0.0)
+            std::cout << " mixer " << fftw.mixfreq << " (band " << fftw.mixfreq - fftw.rate() / 4.0 << " to "
+                      << fftw.mixfreq + fftw.rate() / 4.0 << ")";
+    }
+    if (fftw.trftype == FFTWCalc::SlidingDFT) {
+        std::cout << "\nTransform: " << FFTWCalc::TransformTypeName(fftw.trftype) << " length "
+                  << fftw.sliding.length() << ", bins";
+        for (auto b : fftw.sliding.bins())
+            std::cout << " " << b;
+    } else if (fftw.trftype == FFTWCalc::Zoom) {
+        std::cout << "\nTransform: " << FFTWCalc::TransformTypeName(fftw.trftype) << " center " << fftw.zoom_center
+                  << " span " << fftw.zoom_span << ", " << fftw.zoom_bins << " bins";
+        if (fftw.zoom)
+            std::cout << " (convolution size " << fftw.zoom->convolutionSize() << ")";
+    } else if (fftw.trftype == FFTWCalc::R2r_1d) {
+        std::cout << "\nTransform: " << FFTWCalc::TransformTypeName(fftw.trftype) << " "
+                  << FFTWCalc::R2rKindName(fftw.r2r_kind);
+        if (fftw.r2r_inverse) {
+            std::cout << ", inverse";
+            if (fftw.r2r_keep)
+                std::cout << " of " << fftw.r2r_keep << " coefficients";
+        }
+    } else if (fftw.trftype == FFTWCalc::R2c_2d) {
+        std::cout << "\nTransform: " << FFTWCalc::TransformTypeName(fftw.trftype) << " " << fftw.image_rows()
+                  << " x " << fftw.image_cols();
+        if (fftw.img_threads > 1)
+            std::cout << ", " << fftw.img_threads << " threads";
+    } else if (fftw.trftype == FFTWCalc::Order) {
+        std::cout << "\nTransform: " << FFTWCalc::TransformTypeName(fftw.trftype) << " "
+                  << fftw.order.samplesPerRev() << " samples/rev, " << fftw.order.pulsesPerRev() << " pulses/rev, "
+                  << fftw.order.revolutions() << " revs of " << fftw.order.period() << " samples (table built "
+                  << fftw.order.rebuilds() << " times)";
+    }
+    std::cout
               << "\nWindow type: " << FFTWCalc::WindowTypeName(fftw.wintype)
               << "\nSample freq: " << fftw.fsamp
-              << "\nExec time: " << lasttime;
+              << "\nExec time: " << lasttime
+              << "\nPriority: " << FFTWScheduler::PriorityName(priority);
+    if (deadline > 0.0)
+        std::cout << " deadline: " << deadline << (skipLate ? " (skip late)" : "");
+    std::cout << "\nRuns: " << nRuns << " coalesced: " << nCoalesced;
+    if (deadline > 0.0)
+        std::cout << " deadline misses: " << nDeadlineMiss << " skipped: " << nSkipped;
+    std::cout << "\nMemory: " << mem.used() << " bytes (all instances " << FFTWMemory::total() << ", on huge pages "
+              << FFTWMemory::huge() << ")";
+    if (nRuns)
+        std::cout << "\nQueue latency: " << qlatLast << " (avg " << qlatSum / nRuns << ", max " << qlatMax << ")";
+    if (verbosity > 0) {
+        std::cout << "\nTiming [s] (wall clock, cpu = mean thread CPU time):";
+        stats.show(verbosity, 2);
+    }
+    if (verbosity > 2) {
+        std::cout << "\nHardware counters (per run):";
+        perfExec.show("exec", 2);
+        perfPostProc.show("postproc", 2);
+    }
     std::cout << std::endl;
 }
 
+bool
+FFTWInstance::setNumaNode(const int node)
+{
+    FFTWScheduler *s = FFTWNuma::scheduler(node);
+    if (!s)
+        return false;
+    if (numaNode >= 0)
+        FFTWNuma::release(numaNode);
+    numaNode = node;
+    sched = s;
+    mem.node = node;
+    return true;
+}
+
+size_t
+FFTWInstance::workerCount()
+{
+    return scheduler.workerCount() + FFTWNuma::workerCount();
+}
+
+double
+FFTWInstance::busyTime()
+{
+    return scheduler.busyTime() + FFTWNuma::busyTime();
+}
+
+size_t
+FFTWInstance::pendingCount()
+{
+    return scheduler.pendingCount() + FFTWNuma::pendingCount();
+}
+
+// Rates are measured over the interval since the previous report
+// (since instance creation for the first one)
+void
+FFTWInstance::report(const unsigned int format)
+{
+    static const FFTWStats::Phase phases[] = {FFTWStats::QueueWait,
+                                              FFTWStats::Prepare,
+                                              FFTWStats::Window,
+                                              FFTWStats::Plan,
+                                              FFTWStats::Execute,
+                                              FFTWStats::PostProc,
+                                              FFTWStats::Publish,
+                                              FFTWStats::Total};
+    struct Row
+    {
+        FFTWInstance *inst;
+        double rate, wall, cpu, p99, cpuShare, poolShare, overrun;
+        size_t mem;
+    };
+
+    Guard G(reportLock);
+    const double now = FFTWScheduler::now();
+    const double busy = busyTime();
+    const size_t nworkers = workerCount();
+
+    std::vector<Row> rows;
+    double cpuTotal = 0.0;
+    for (auto inst : instances) {
+        Row r;
+        r.inst = inst;
+        const size_t triggers = epicsAtomicGetSizeT(&inst->nTriggers);
+        const double since = reportTime > 0.0 ? reportTime : inst->createTime;
+        r.rate = now > since ? (triggers - inst->reportTriggers) / (now - since) : 0.0;
+        inst->reportTriggers = triggers;
+
+        // cost of one calculation (without queueing)
+        r.wall = r.cpu = 0.0;
+        for (size_t p = 1; p < sizeof(phases) / sizeof(phases[0]) - 1; p++) {
+            FFTWStats::Summary s = inst->stats.summary(phases[p]);
+            r.wall += s.mean;
+            r.cpu += s.cpumean;
+        }
+        r.p99 = inst->stats.summary(FFTWStats::Total).p99;
+        r.cpuShare = r.rate * r.cpu;
+        r.poolShare = nworkers ? r.rate * r.wall / nworkers : 0.0;
+        // fraction of the trigger period used from trigger to scan request
+        r.overrun = r.rate * r.p99;
+        r.mem = inst->mem.used();
+        cpuTotal += r.cpuShare;
+        rows.push_back(r);
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.overrun > b.overrun; });
+
+    const double interval = reportTime > 0.0 ? now - reportTime : 0.0;
+    const double utilization = interval > 0.0 && nworkers ? (busy - reportBusy) / (interval * nworkers) : 0.0;
+    reportTime = now;
+    reportBusy = busy;
+
+    if (format > 1) {
+        for (auto &r : rows) {
+            std::cout << "{\"instance\":\"" << r.inst->name << "\",\"rate\":" << r.rate << ",\"cost\":" << r.wall
+                      << ",\"cpu\":" << r.cpu << ",\"cpu_share\":" << r.cpuShare << ",\"pool_share\":" << r.poolShare
+                      << ",\"overrun\":" << r.overrun << ",\"memory\":" << r.mem << ",\"phases\":{";
+            for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+                FFTWStats::Summary s = r.inst->stats.summary(phases[p]);
+                std::cout << (p ? "," : "") << "\"" << FFTWStats::PhaseName(phases[p]) << "\":[" << s.mean << ","
+                          << s.p99 << "]";
+            }
+            std::cout << "}}\n";
+        }
+        std::cout << "{\"pool\":{\"workers\":" << nworkers << ",\"utilization\":" << utilization
+                  << ",\"pending\":" << pendingCount() << ",\"cpu_share\":" << cpuTotal
+                  << ",\"memory\":" << FFTWMemory::total() << ",\"huge_pages\":" << FFTWMemory::huge() << "}}" << std::endl;
+        return;
+    }
+
+    std::cout << "FFTW instances: " << instances.size() << ", workers: " << nworkers << ", pool utilization: ";
+    if (interval > 0.0)
+        std::cout << std::setprecision(3) << 100.0 * utilization << "% (last " << interval << " s)";
+    else
+        std::cout << "n/a (first report)";
+    std::cout << "\nProjected CPU: " << 100.0 * cpuTotal << "% of one core, memory: " << FFTWMemory::total() / 1024 << " KiB"
+              << "\n" << std::left << std::setw(24) << "instance" << std::right << std::setw(10) << "rate [Hz]"
+              << std::setw(12) << "cost [s]" << std::setw(12) << "p99 [s]" << std::setw(8) << "cpu" << std::setw(8)
+              << "pool" << std::setw(10) << "overrun" << std::setw(12) << "mem [KiB]" << std::endl;
+    for (auto &r : rows) {
+        std::cout << std::left << std::setw(24) << r.inst->name << std::right << std::setw(10) << r.rate
+                  << std::setw(12) << r.wall << std::setw(12) << r.p99 << std::setw(7) << 100.0 * r.cpuShare << "%"
+                  << std::setw(7) << 100.0 * r.poolShare << "%" << std::setw(9) << 100.0 * r.overrun << "%"
+                  << std::setw(12) << r.mem / 1024 << std::endl;
+        if (format > 0) {
+            std::cout << "   ";
+            for (auto p : phases) {
+                FFTWStats::Summary s = r.inst->stats.summary(p);
+                std::cout << " " << FFTWStats::PhaseName(p) << " " << s.mean << "/" << s.p99;
+            }
+            std::cout << std::endl;
+        }
+    }
+    std::cout << std::setprecision(6);
+}
+
+// Careful: not thread safe (ok during record initialization)
+void
+FFTWInstance::useChannels(const FFTWConnector *conn)
+{
+    const size_t last = conn->getChannel() + conn->getChannelCount();
+    switch (conn->sigtype) {
+    case FFTWConnector::InputReal:
+        if (last > fftw.nchan)
+            fftw.set_nchan(last);
+        break;
+    case FFTWConnector::OutputReal:
+    case FFTWConnector::OutputImag:
+    case FFTWConnector::OutputMagn:
+    case FFTWConnector::OutputPhas:
+    case FFTWConnector::OutputCoef:
+    case FFTWConnector::OutputInverse:
+    case FFTWConnector::OutputProfile:
+        if (last > chanUsed.size())
+            chanUsed.resize(last, false);
+        chanUsed[conn->getChannel()] = true;
+        break;
+    case FFTWConnector::OutputAnalytic:
+        if (last > hilbert.size())
+            hilbert.resize(last);
+        if (!hilbert[conn->getChannel()]) {
+            hilbert[conn->getChannel()].reset(new FFTWHilbert);
+            hilbert[conn->getChannel()]->set_memory(&mem);
+        }
+        useAnalytic[conn->analyticQuantity] = true;
+        break;
+    case FFTWConnector::OutputCorr:
+    case FFTWConnector::CorrDelay:
+        if (!correlator) {
+            correlator.reset(new FFTWCorrelate);
+            correlator->set_memory(&mem);
+        }
+        if (last > corrUsed.size())
+            corrUsed.resize(last, false);
+        corrUsed[conn->getChannel()] = true;
+        break;
+    case FFTWConnector::OutputCross:
+        if (last > cross.size())
+            cross.resize(last);
+        if (!cross[conn->getChannel()])
+            cross[conn->getChannel()].reset(new FFTWCross);
+        break;
+    default:
+        break;
+    }
+}
+
 // Careful: not thread safe (ok during record initialization)
 void FFTWInstance::setRequiredOutputSize(const FFTWConnector::SignalType type, const epicsUInt32 size)
 {
@@ -285,6 +837,38 @@ void FFTWInstance::setRequiredOutputSize(const FFTWConnector::SignalType type, c
         if (size > sizeWindow)
             sizeWindow = size;
         break;
+    case FFTWConnector::StatisticHist:
+        if (size > sizeStatHist)
+            sizeStatHist = size;
+        break;
+    case FFTWConnector::OutputPeak:
+        if (size > sizePeak)
+            sizePeak = size;
+        break;
+    case FFTWConnector::OutputCross:
+        if (size > sizeCross)
+            sizeCross = size;
+        break;
+    case FFTWConnector::OutputCorr:
+        if (size > sizeCorr)
+            sizeCorr = size;
+        break;
+    case FFTWConnector::OutputAnalytic:
+        if (size > sizeAnalytic)
+            sizeAnalytic = size;
+        break;
+    case FFTWConnector::OutputCoef:
+        if (size > sizeCoef)
+            sizeCoef = size;
+        break;
+    case FFTWConnector::OutputInverse:
+        if (size > sizeInverse)
+            sizeInverse = size;
+        break;
+    case FFTWConnector::OutputProfile:
+        if (size > sizeProfile)
+            sizeProfile = size;
+        break;
     default:
         break;
     }
@@ -307,16 +891,3 @@ FFTWInstance::find(const std::string &name)
             return it;
     return nullptr;
 }
-
-void
-FFTWInstance::calcJob(void *arg, epicsJobMode mode)
-{
-    auto instance = reinterpret_cast<FFTWInstance *>(arg);
-    if (mode == epicsJobModeCleanup) {
-        epicsJobDestroy(instance->job);
-        return;
-    }
-    if (FFTWDebug)
-        std::cerr << "Running calculation for instance " << instance->name << std::endl;
-    instance->calculate();
-}
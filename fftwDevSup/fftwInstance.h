@@ -21,59 +21,25 @@
 #include <fftw3.h>
 
 #include <dbScan.h>
-#include <epicsThreadPool.h>
 #include <epicsTime.h>
 
 #include "fftwConnector.h"
 #include "fftwCalc.h"
-
-// Windows implementation of clock_gettime
-#ifdef _WIN32
-#define CLOCK_PROCESS_CPUTIME_ID 0
-#    include <Windows.h>
-#    include <minwinbase.h>
-int clock_gettime(int, struct timespec *spec);
-#endif
-
-// Performance timer
-struct PTimer {
-    timespec tstart;
-    PTimer() {start();}
-    void start()
-    {
-        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tstart);
-    }
-    double snap()
-    {
-        timespec now;
-        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
-        double ret = now.tv_sec-tstart.tv_sec + 1e-9*(now.tv_nsec-tstart.tv_nsec);
-        tstart = now;
-        return ret;
-    }
-    // Print msg if elapsed time is greater than the given threshold
-    void maybeSnap(const char *msg, double threshold=0.0)
-    {
-        double interval = snap();
-        if(FFTWDebug && interval>threshold) {
-            errlogPrintf("%s over threshold %f > %f\n", msg, interval, threshold);
-        }
-    }
-};
+#include "fftwCorrelate.h"
+#include "fftwCross.h"
+#include "fftwHilbert.h"
+#include "fftwPeaks.h"
+#include "fftwPerf.h"
+#include "fftwProfile.h"
+#include "fftwScheduler.h"
+#include "fftwStats.h"
 
 class FFTWConnector;
+class FFTWGroup;
 
 //typedef std::vector<double, FFTWAllocator<double>> FFTWvector_d;
 //typedef std::vector<fftw_complex, FFTWAllocator<fftw_complex>> FFTWvector_c;
 
-struct FFTWThreadPool
-{
-    FFTWThreadPool();
-    ~FFTWThreadPool();
-    epicsThreadPool *pool;
-    epicsThreadPoolConfig poolConfig;
-};
-
 class FFTWInstance
 {
 public:
@@ -87,12 +53,76 @@ public:
     std::vector<FFTWConnector *> inputs;
     std::vector<FFTWConnector *> outputs;
 
-    std::shared_ptr<std::vector<double>> outReal, outImag, outMagn, outPhas, outFscale, outWindow;
+    // Per channel outputs
+    std::vector<std::shared_ptr<std::vector<double>>> outReal, outImag, outMagn, outPhas;
+    std::vector<bool> chanUsed;
+    std::shared_ptr<std::vector<double>> outFscale, outWindow;
     bool useReal, useImag, useMagn, usePhas, useFscale, useWindow;
-    size_t sizeReal, sizeImag, sizeMagn, sizePhas, sizeFscale, sizeWindow;
+    size_t sizeReal, sizeImag, sizeMagn, sizePhas, sizeFscale, sizeWindow, sizeStatHist;
+
+    // Peak finding and harmonic analysis, per channel results
+    FFTWPeaks peaks;
+    std::vector<FFTWPeaks::Result> outPeaks;
+    bool usePeaks, useHarmonics;
+    size_t sizePeak;
+
+    // Cross spectra of each response channel against channel 0, frames averaged
+    std::vector<std::unique_ptr<FFTWCross>> cross;
+    size_t crossAverage;
+    size_t sizeCross;
+
+    // Correlation of each channel against channel 0 (raw inputs), lag of its maximum [s]
+    std::vector<std::shared_ptr<std::vector<double>>> outCorr;
+    std::vector<double> corrDelay;
+    std::vector<bool> corrUsed;
+    size_t sizeCorr;
+
+    // Analytic signal per channel (raw inputs): output arrays
+    std::vector<std::shared_ptr<std::vector<double>>> outAnalytic[FFTWHilbert::NQuantities];
+    bool useAnalytic[FFTWHilbert::NQuantities];
+    size_t sizeAnalytic;
+
+    // Real-to-real transforms: per channel coefficients and inverse
+    std::vector<std::shared_ptr<std::vector<double>>> outCoef, outInverse;
+    bool useCoef, useInverse;
+    size_t sizeCoef, sizeInverse;
+
+    // 2D transforms: per channel spectrum profiles
+    std::vector<std::shared_ptr<std::vector<double>>> outProfile[FFTWProfile::NKinds];
+    bool useProfile[FFTWProfile::NKinds];
+    size_t sizeProfile;
+
+    // Accounting of all buffers (declared before the buffers' owners)
+    FFTWMemory mem;
 
     PTimer calctime;
     FFTWCalc fftw;
+    std::unique_ptr<FFTWCorrelate> correlator;
+    std::vector<std::unique_ptr<FFTWHilbert>> hilbert;
+    FFTWStats stats;
+
+    // Hardware counters of the transform and the post-processing
+    FFTWPerf::Section perfExec, perfPostProc;
+
+    // Group for batched execution (nullptr = calculate alone)
+    FFTWGroup *group;
+
+    // NUMA node the instance is bound to (-1 = none) and its scheduler
+    int numaNode;
+    FFTWScheduler *sched;
+
+    // Scheduling parameters and statistics (protected by the scheduler lock)
+    FFTWScheduler::Priority priority;
+    double deadline; // budget after trigger [s], 0 = none
+    bool skipLate;   // skip runs that start after their deadline
+    bool pending, running;
+    double trigtime, runTrigtime;
+    double qlatLast, qlatMax, qlatSum;
+    unsigned long nRuns, nDeadlineMiss, nSkipped, nCoalesced;
+
+    // Trigger counter (atomic), creation time [s, monotonic]
+    size_t nTriggers;
+    double createTime;
 
     IOSCANPVT valueScan, scaleScan, windowScan;
 
@@ -101,6 +131,20 @@ public:
     // Show method to print the setup
     void show(const unsigned int verbosity) const;
 
+    // Bind to a NUMA node (workers, buffers), false if not possible
+    bool setNumaNode(const int node);
+
+    // Sums over all worker pools
+    static size_t workerCount();
+    static double busyTime();
+    static size_t pendingCount();
+
+    // Print the capacity report of all instances (0 = table, 1 = with phases, 2 = JSON lines)
+    static void report(const unsigned int format);
+
+    // Register the channels used by a connector
+    void useChannels(const FFTWConnector *conn);
+
     // Set minimum output size (largest connected array record)
     void setRequiredOutputSize(const FFTWConnector::SignalType type, const epicsUInt32 size);
 
@@ -110,18 +154,36 @@ public:
     // Factory method to create an instance
     static FFTWInstance *findOrCreate(const std::string &name);
 
-    // epicsThreadPool interface
-    static void calcJob(void *arg, epicsJobMode mode);
+    // Transformation routine called from the job (or synchronously by the benchmark)
+    void calculate();
 
 private:
+    friend class FFTWScheduler;
+    friend class FFTWGroup;
+    friend class FFTWLoad;
+
     FFTWInstance(const std::string &name);
 
-    // Transformation routine called from the job
-    void calculate();
+    // Phases of the calculation
+    // - move new values from the input connectors into the calculation (false: no input yet)
+    bool fetchInputs();
+    // - post-process the transform result, push to output connectors and request scans
+    void publish();
+    // - reduced copy of an output array for a connector with a reduction (rebuild: new frequency scale)
+    std::shared_ptr<std::vector<double>> reduced(FFTWConnector *conn,
+                                                 const std::shared_ptr<std::vector<double>> &full,
+                                                 const bool rebuild);
+
+    epicsTimeStamp ts;
+    bool windowChanged, fscaleChanged;
+
+    // Trigger count at the previous report
+    size_t reportTriggers;
 
     static std::vector<FFTWInstance *> instances;
-    static FFTWThreadPool workers;
-    epicsJob *job;
+    static double reportTime, reportBusy;
+    static epicsMutex reportLock; // serializes reports (report state, reportTriggers)
+    static FFTWScheduler scheduler;
 };
 
 #endif // FFTWINSTANCE_H
@@ -0,0 +1,234 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include <dbCommon.h>
+#include <dbLock.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include "fftwConnector.h"
+#include "fftwInstance.h"
+#include "fftwLoad.h"
+
+// Saturation criteria for one step
+static const double maxDropRate = 0.05;
+static const double maxUtilization = 0.9;
+
+bool
+FFTWLoad::parse(const std::string &name, Signal &signal)
+{
+    for (auto s : {Sines, Noise, Chirp}) {
+        if (name == SignalName(s)) {
+            signal = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+FFTWLoad::FFTWLoad(const Signal signal, const size_t npoints)
+    : signal(signal)
+    , npoints(npoints)
+{}
+
+bool
+FFTWLoad::add(FFTWInstance *inst)
+{
+    FFTWConnector *conn = inst->triggerSrc;
+    if (!conn || conn->sigtype != FFTWConnector::InputReal)
+        return false;
+    for (auto &t : targets)
+        if (t.inst == inst)
+            return true;
+
+    Target t;
+    t.inst = inst;
+    t.conn = conn;
+    t.next = 0;
+    generate(t, conn->getChannelCount());
+    targets.push_back(std::move(t));
+    return true;
+}
+
+size_t
+FFTWLoad::addAll()
+{
+    for (auto inst : FFTWInstance::instances)
+        add(inst);
+    return targets.size();
+}
+
+// Fill the frames of all channels of a target
+// - sines: mixture of three tones, continuous across frames
+// - noise: white gaussian noise
+// - chirp: linear sweep from DC to Nyquist within each frame
+void
+FFTWLoad::generate(Target &target, const size_t nchan)
+{
+    std::mt19937 rng(static_cast<unsigned>(targets.size() + 1));
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    const double pi = 4.0 * atan(1.0);
+
+    target.frames.assign(nframes * nchan, std::vector<double>(npoints));
+    for (size_t f = 0; f < nframes; f++) {
+        for (size_t c = 0; c < nchan; c++) {
+            std::vector<double> &frame = target.frames[f * nchan + c];
+            for (size_t i = 0; i < npoints; i++) {
+                const double n = static_cast<double>(f * npoints + i);
+                switch (signal) {
+                case Sines:
+                    frame[i] = sin(2 * pi * 0.0371 * n + c) + 0.5 * sin(2 * pi * 0.1234 * n)
+                               + 0.1 * sin(2 * pi * 0.3011 * n);
+                    break;
+                case Noise:
+                    frame[i] = gauss(rng);
+                    break;
+                case Chirp:
+                    frame[i] = cos(pi * 0.5 * i * i / npoints + c);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Hand one frame to the instance, the same way record processing does
+void
+FFTWLoad::inject(Target &target)
+{
+    FFTWConnector *conn = target.conn;
+    const size_t nchan = conn->getChannelCount();
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+
+    dbScanLock(conn->prec);
+    for (size_t c = 0; c < nchan; c++) {
+        std::vector<double> &frame = target.frames[target.next * nchan + c];
+        conn->setNextInputValue(frame.data(), static_cast<epicsUInt32>(frame.size()), c);
+    }
+    conn->setTimestamp(now);
+    conn->trigger();
+    dbScanUnlock(conn->prec);
+
+    target.next = (target.next + 1) % nframes;
+}
+
+FFTWLoad::Step
+FFTWLoad::step(const double rate, const double duration)
+{
+    const size_t nworkers = FFTWInstance::workerCount();
+    for (auto &t : targets) {
+        const FFTWScheduler::Counters c = t.inst->sched->counters(t.inst);
+        t.runs0 = c.runs;
+        t.coalesced0 = c.coalesced;
+        t.skipped0 = c.skipped;
+        t.qlat0 = c.qlatSum;
+    }
+    const double busy0 = FFTWInstance::busyTime();
+    const double quantum = std::max(epicsThreadSleepQuantum(), 1e-4);
+
+    // trigger all targets at the given rate, catching up in bursts after sleeping
+    const double t0 = FFTWScheduler::now();
+    unsigned long sent = 0;
+    double elapsed;
+    while ((elapsed = FFTWScheduler::now() - t0) < duration) {
+        const unsigned long due = static_cast<unsigned long>(rate * elapsed) + 1;
+        while (sent < due) {
+            for (auto &t : targets)
+                inject(t);
+            sent++;
+        }
+        epicsThreadSleep(std::min(quantum, 1.0 / rate));
+    }
+    // let the queue drain
+    epicsThreadSleep(0.1);
+    while (FFTWInstance::pendingCount())
+        epicsThreadSleep(quantum);
+
+    Step s;
+    unsigned long runs = 0, skipped = 0, drops = 0;
+    double qlat = 0.0;
+    s.qlatP99 = 0.0;
+    for (auto &t : targets) {
+        const FFTWScheduler::Counters c = t.inst->sched->counters(t.inst);
+        runs += c.runs - t.runs0;
+        skipped += c.skipped - t.skipped0;
+        drops += c.coalesced - t.coalesced0;
+        qlat += c.qlatSum - t.qlat0;
+        s.qlatP99 = std::max(s.qlatP99, t.inst->stats.summary(FFTWStats::QueueWait).p99);
+    }
+    const double offered = static_cast<double>(sent * targets.size());
+    s.offered = offered / elapsed;
+    // coalesced triggers never start a run, skipped runs are counted as runs
+    drops += skipped;
+    s.sustained = (runs - skipped) / elapsed;
+    s.droprate = offered > 0.0 ? drops / offered : 0.0;
+    s.qlatMean = runs ? qlat / runs : 0.0;
+    s.utilization = (FFTWInstance::busyTime() - busy0) / (elapsed * nworkers);
+    s.saturated = s.droprate > maxDropRate || s.utilization > maxUtilization;
+    return s;
+}
+
+void
+FFTWLoad::run(double rate, const double maxrate, const double duration)
+{
+    std::cout << "Load: " << targets.size() << " instance(s), " << SignalName(signal) << " signal, " << npoints
+              << " points, " << FFTWInstance::workerCount() << " worker(s)\n"
+              << std::setw(12) << "rate [Hz]" << std::setw(12) << "offered" << std::setw(12) << "sustained"
+              << std::setw(8) << "drop" << std::setw(12) << "qlat avg" << std::setw(12) << "qlat p99"
+              << std::setw(8) << "util" << std::endl;
+
+    double lastGood = 0.0;
+    bool saturated = false;
+    while (true) {
+        Step s = step(rate, duration);
+        std::cout << std::setw(12) << rate << std::setw(12) << s.offered << std::setw(12) << s.sustained
+                  << std::setw(7) << 100.0 * s.droprate << "%" << std::setw(12) << s.qlatMean << std::setw(12)
+                  << s.qlatP99 << std::setw(7) << 100.0 * s.utilization << "%" << std::endl;
+        if (s.saturated) {
+            saturated = true;
+            break;
+        }
+        lastGood = s.sustained;
+        if (rate >= maxrate)
+            break;
+        rate = std::min(2.0 * rate, maxrate);
+    }
+
+    if (saturated)
+        std::cout << "Saturated at " << rate << " Hz per instance, last sustained total rate " << lastGood << " Hz\n";
+    else
+        std::cout << "Not saturated, sustained total rate " << lastGood << " Hz\n";
+
+    std::cout << "Cost per calculation [s]:\n"
+              << std::setw(24) << "instance" << std::setw(12) << "wall" << std::setw(12) << "cpu" << std::setw(12)
+              << "total p99" << std::endl;
+    for (auto &t : targets) {
+        double wall = 0.0, cpu = 0.0;
+        for (auto p : {FFTWStats::Prepare,
+                       FFTWStats::Window,
+                       FFTWStats::Plan,
+                       FFTWStats::Execute,
+                       FFTWStats::PostProc,
+                       FFTWStats::Publish}) {
+            FFTWStats::Summary s = t.inst->stats.summary(p);
+            wall += s.mean;
+            cpu += s.cpumean;
+        }
+        std::cout << std::setw(24) << t.inst->name << std::setw(12) << wall << std::setw(12) << cpu << std::setw(12)
+                  << t.inst->stats.summary(FFTWStats::Total).p99 << std::endl;
+    }
+}
@@ -0,0 +1,92 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWLOAD_H
+#define FFTWLOAD_H
+
+#include <string>
+#include <vector>
+
+class FFTWInstance;
+class FFTWConnector;
+
+// FFTWLoad
+// - synthetic load generator for capacity planning
+// - feeds generated signals through the trigger record's input connector
+// - steps the trigger rate up until the workers saturate, reports the cost
+
+class FFTWLoad
+{
+public:
+    enum Signal {
+        Sines = 0,
+        Noise,
+        Chirp
+    };
+
+    static inline const char *
+    SignalName(const Signal s)
+    {
+        switch (s) {
+        case Sines:
+            return "sine";
+        case Noise:
+            return "noise";
+        case Chirp:
+            return "chirp";
+        }
+        return "?";
+    }
+
+    // Parse a signal name, false if unknown
+    static bool parse(const std::string &name, Signal &signal);
+
+    FFTWLoad(const Signal signal, const size_t npoints);
+
+    // Add an instance, false if it is not triggered by an input record
+    bool add(FFTWInstance *inst);
+
+    // Add all instances that can be driven
+    size_t addAll();
+
+    // Run steps of the given duration [s], doubling the rate [Hz per instance]
+    // up to maxrate or until saturation, print the results
+    void run(double rate, const double maxrate, const double duration);
+
+private:
+    // Frames generated in advance and cycled through
+    static const size_t nframes = 8;
+
+    struct Target
+    {
+        FFTWInstance *inst;
+        FFTWConnector *conn;
+        std::vector<std::vector<double>> frames;
+        size_t next;
+        unsigned long runs0, coalesced0, skipped0;
+        double qlat0;
+    };
+
+    struct Step
+    {
+        double offered, sustained, droprate, qlatMean, qlatP99, utilization;
+        bool saturated;
+    };
+
+    Signal signal;
+    size_t npoints;
+    std::vector<Target> targets;
+
+    void generate(Target &target, const size_t chan);
+    void inject(Target &target);
+    Step step(const double rate, const double duration);
+};
+
+#endif // FFTWLOAD_H
@@ -0,0 +1,215 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <cstdint>
+#include <map>
+#include <new>
+
+#include <fftw3.h>
+
+#include <epicsAtomic.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+
+#ifdef __linux__
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+#include "fftwMemory.h"
+#include "fftwNuma.h"
+
+int FFTWHugePages;
+
+namespace {
+
+size_t totalBytes;
+size_t hugeBytes;
+
+#ifdef __linux__
+
+// Buffers mapped directly (huge pages or NUMA placement)
+struct Mapping
+{
+    size_t len;
+    bool huge;
+};
+
+epicsMutex &
+mappedLock()
+{
+    static epicsMutex lock;
+    return lock;
+}
+
+std::map<void *, Mapping> &
+mappedBuffers()
+{
+    static std::map<void *, Mapping> buffers;
+    return buffers;
+}
+
+void *
+allocateMapped(const size_t bytes, const int node)
+{
+    const bool huge = FFTWHugePages && bytes >= FFTWMemory::hugePageSize;
+    const size_t page = huge ? FFTWMemory::hugePageSize : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t len = (bytes + page - 1) / page * page;
+    void *p = MAP_FAILED;
+
+    if (huge && FFTWHugePages > 1)
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (p == MAP_FAILED && huge) {
+        // transparent huge pages: map a huge page aligned region and ask the kernel to back it
+        void *raw = mmap(nullptr, len + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return nullptr;
+        const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t aligned = (start + page - 1) / page * page;
+        if (aligned > start)
+            munmap(raw, aligned - start);
+        if (start + page > aligned)
+            munmap(reinterpret_cast<void *>(aligned + len), start + page - aligned);
+        p = reinterpret_cast<void *>(aligned);
+        madvise(p, len, MADV_HUGEPAGE);
+    } else if (p == MAP_FAILED) {
+        p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return nullptr;
+    }
+
+    // before the first touch: pages are placed on the node whichever thread writes them
+    if (node >= 0)
+        FFTWNuma::bindMemory(p, len, node);
+
+    epicsGuard<epicsMutex> G(mappedLock());
+    mappedBuffers()[p] = {len, huge};
+    if (huge)
+        epicsAtomicAddSizeT(&hugeBytes, len);
+    return p;
+}
+
+// false if p is not a mapped buffer
+bool
+releaseMapped(void *p)
+{
+    Mapping m;
+    {
+        epicsGuard<epicsMutex> G(mappedLock());
+        auto it = mappedBuffers().find(p);
+        if (it == mappedBuffers().end())
+            return false;
+        m = it->second;
+        mappedBuffers().erase(it);
+    }
+    munmap(p, m.len);
+    if (m.huge)
+        epicsAtomicSubSizeT(&hugeBytes, m.len);
+    return true;
+}
+
+#endif // __linux__
+
+} // namespace
+
+FFTWMemory::FFTWMemory()
+    : node(-1)
+    , bytes(0)
+{}
+
+size_t
+FFTWMemory::used() const
+{
+    return epicsAtomicGetSizeT(&bytes);
+}
+
+size_t
+FFTWMemory::total()
+{
+    return epicsAtomicGetSizeT(&totalBytes);
+}
+
+size_t
+FFTWMemory::huge()
+{
+    return epicsAtomicGetSizeT(&hugeBytes);
+}
+
+void
+FFTWMemory::add(const size_t n)
+{
+    epicsAtomicAddSizeT(&bytes, n);
+    epicsAtomicAddSizeT(&totalBytes, n);
+}
+
+void
+FFTWMemory::sub(const size_t n)
+{
+    epicsAtomicSubSizeT(&bytes, n);
+    epicsAtomicSubSizeT(&totalBytes, n);
+}
+
+void *
+FFTWMemory::allocate(const size_t bytes, FFTWMemory *acct)
+{
+    void *p = nullptr;
+#ifdef __linux__
+    if ((FFTWHugePages && bytes >= hugePageSize) || (acct && acct->node >= 0 && bytes >= mapThreshold))
+        p = allocateMapped(bytes, acct ? acct->node : -1);
+#endif
+    if (!p)
+        p = fftw_malloc(bytes);
+    if (!p)
+        throw std::bad_alloc();
+
+    if (acct)
+        acct->add(bytes);
+    else
+        epicsAtomicAddSizeT(&totalBytes, bytes);
+    return p;
+}
+
+void
+FFTWMemory::release(void *p, const size_t bytes, FFTWMemory *acct)
+{
+    if (!p)
+        return;
+#ifdef __linux__
+    if (!(bytes >= mapThreshold && releaseMapped(p)))
+#endif
+        fftw_free(p);
+
+    if (acct)
+        acct->sub(bytes);
+    else
+        epicsAtomicSubSizeT(&totalBytes, bytes);
+}
+
+std::shared_ptr<std::vector<double>>
+FFTWMemory::makeVector(const size_t size, const size_t capacity)
+{
+    auto vec = new std::vector<double>(size);
+    vec->reserve(capacity);
+    const size_t n = vec->capacity() * sizeof(double);
+    add(n);
+    // instances live forever, the accounting object outlives the vector
+    FFTWMemory *acct = this;
+    return std::shared_ptr<std::vector<double>>(vec, [acct, n](std::vector<double> *v) {
+        acct->sub(n);
+        delete v;
+    });
+}
+
+#include <epicsExport.h>
+
+extern "C" {
+epicsExportAddress(int, FFTWHugePages);
+}
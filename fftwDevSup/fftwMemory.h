@@ -0,0 +1,60 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWMEMORY_H
+#define FFTWMEMORY_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+extern int FFTWHugePages;
+
+// FFTWMemory
+// - byte counter of the buffers held by one instance (and a global one)
+// - allocation of FFTW buffers, large buffers optionally on 2 MB huge pages
+//   (FFTWHugePages: 0 = off, 1 = transparent huge pages, 2 = explicit huge pages
+//   falling back to transparent ones) and on the instance's NUMA node
+
+class FFTWMemory
+{
+public:
+    // Buffers from this size on are candidates for huge pages
+    static const size_t hugePageSize = 2 * 1024 * 1024;
+    // Buffers from this size on are placed on the NUMA node
+    static const size_t mapThreshold = 64 * 1024;
+
+    FFTWMemory();
+
+    // NUMA node for the buffers (-1 = no placement)
+    int node;
+
+    // Bytes currently held
+    size_t used() const;
+
+    // Bytes held by all instances (and unaccounted buffers) / on huge pages
+    static size_t total();
+    static size_t huge();
+
+    // Allocate/free a buffer (SIMD aligned), accounted to acct (may be nullptr)
+    static void *allocate(const size_t bytes, FFTWMemory *acct);
+    static void release(void *p, const size_t bytes, FFTWMemory *acct);
+
+    // New output vector, accounted until the last reference (e.g. a record) lets go
+    std::shared_ptr<std::vector<double>> makeVector(const size_t size, const size_t capacity);
+
+private:
+    size_t bytes;
+
+    void add(const size_t n);
+    void sub(const size_t n);
+};
+
+#endif // FFTWMEMORY_H
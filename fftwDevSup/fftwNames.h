@@ -0,0 +1,30 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWNAMES_H
+#define FFTWNAMES_H
+
+#include <string>
+
+// Parse the name of an enum value: values 0 .. count-1, named by nameOf(), false if unknown
+template<typename E>
+bool
+parseName(const std::string &name, const int count, const char *(*nameOf)(E), E &e)
+{
+    for (int i = 0; i < count; i++) {
+        if (name == nameOf(static_cast<E>(i))) {
+            e = static_cast<E>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // FFTWNAMES_H
@@ -0,0 +1,298 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsThreadPool.h>
+#include <errlog.h>
+
+#ifdef __linux__
+#    include <linux/mempolicy.h>
+#    include <sched.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+#include "fftwNuma.h"
+#include "fftwScheduler.h"
+
+namespace {
+
+struct NodePool
+{
+    std::vector<int> cpus;
+    unsigned int bound; // instances bound to the node
+    FFTWScheduler *sched;
+};
+
+epicsMutex &
+poolsLock()
+{
+    static epicsMutex lock;
+    return lock;
+}
+
+std::vector<NodePool *> &
+pools()
+{
+    static std::vector<NodePool *> p;
+    return p;
+}
+
+// Called with the lock held
+NodePool *
+nodePool(const int node)
+{
+    return node >= 0 && static_cast<size_t>(node) < pools().size() ? pools()[node] : nullptr;
+}
+
+unsigned int
+nodeThreads(const NodePool *np)
+{
+    return np ? std::min(static_cast<unsigned int>(np->cpus.size()), np->bound) : 0;
+}
+
+// Schedulers of the node pools (their locks are taken without holding the pools lock)
+std::vector<FFTWScheduler *>
+schedulers()
+{
+    epicsGuard<epicsMutex> G(poolsLock());
+    std::vector<FFTWScheduler *> s;
+    for (auto np : pools())
+        if (np && (np->bound || np->sched->threadPool()))
+            s.push_back(np->sched);
+    return s;
+}
+
+// Parse a sysfs list ("0-3,8-11")
+std::vector<int>
+parseList(const std::string &list)
+{
+    std::vector<int> items;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        int first, last;
+        char dash;
+        std::istringstream r(range);
+        if (!(r >> first))
+            continue;
+        if (r >> dash >> last && dash == '-') {
+            for (int i = first; i <= last; i++)
+                items.push_back(i);
+        } else {
+            items.push_back(first);
+        }
+    }
+    return items;
+}
+
+std::string
+readLine(const std::string &path)
+{
+    std::ifstream f(path.c_str());
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+#ifdef __linux__
+
+epicsThreadOnceId onceId = EPICS_THREAD_ONCE_INIT;
+epicsThreadPrivateId boundKey;
+cpu_set_t processCpus;
+
+// First called during record initialization, before any worker binds itself
+void
+numaInit(void *)
+{
+    boundKey = epicsThreadPrivateCreate();
+    if (sched_getaffinity(0, sizeof(processCpus), &processCpus)) {
+        CPU_ZERO(&processCpus);
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, &processCpus);
+    }
+}
+
+#endif // __linux__
+
+} // namespace
+
+int
+FFTWNuma::nodes()
+{
+#ifdef __linux__
+    std::vector<int> online = parseList(readLine("/sys/devices/system/node/online"));
+    if (!online.empty())
+        return online.back() + 1;
+#endif
+    return 1;
+}
+
+int
+FFTWNuma::autoNode()
+{
+    int best = -1;
+    double bestLoad = 0.0;
+    for (int node = 0; node < nodes(); node++) {
+        const std::vector<int> nodeCpus = cpus(node);
+        if (nodeCpus.empty())
+            continue;
+        unsigned int bound = 0;
+        {
+            epicsGuard<epicsMutex> G(poolsLock());
+            if (NodePool *np = nodePool(node))
+                bound = np->bound;
+        }
+        const double load = static_cast<double>(bound) / nodeCpus.size();
+        if (best < 0 || load < bestLoad) {
+            best = node;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+std::vector<int>
+FFTWNuma::cpus(const int node)
+{
+    std::ostringstream path;
+    path << "/sys/devices/system/node/node" << node << "/cpulist";
+    std::vector<int> nodeCpus = parseList(readLine(path.str()));
+#ifdef __linux__
+    epicsThreadOnce(&onceId, numaInit, nullptr);
+    std::vector<int> allowed;
+    for (int cpu : nodeCpus)
+        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &processCpus))
+            allowed.push_back(cpu);
+    return allowed;
+#else
+    return nodeCpus;
+#endif
+}
+
+FFTWScheduler *
+FFTWNuma::scheduler(const int node)
+{
+#ifdef __linux__
+    if (node < 0 || node >= nodes())
+        return nullptr;
+    const std::vector<int> nodeCpus = cpus(node);
+    if (nodeCpus.empty())
+        return nullptr;
+
+    epicsGuard<epicsMutex> G(poolsLock());
+    if (pools().size() <= static_cast<size_t>(node))
+        pools().resize(node + 1, nullptr);
+    NodePool *&np = pools()[node];
+    if (!np) {
+        np = new NodePool;
+        np->cpus = nodeCpus;
+        np->bound = 0;
+        np->sched = new FFTWScheduler(node);
+    }
+    np->bound++;
+    return np->sched;
+#else
+    return nullptr;
+#endif
+}
+
+void
+FFTWNuma::release(const int node)
+{
+    epicsGuard<epicsMutex> G(poolsLock());
+    NodePool *np = nodePool(node);
+    if (np && np->bound)
+        np->bound--;
+}
+
+unsigned int
+FFTWNuma::threads(const int node)
+{
+    epicsGuard<epicsMutex> G(poolsLock());
+    if (node >= 0)
+        return std::max(1u, nodeThreads(nodePool(node)));
+
+    epicsThreadPoolConfig config;
+    epicsThreadPoolConfigDefaults(&config);
+    unsigned int used = 0;
+    for (auto np : pools())
+        used += nodeThreads(np);
+    return config.maxThreads > used ? config.maxThreads - used : 1;
+}
+
+void
+FFTWNuma::bindThread(const int node)
+{
+#ifdef __linux__
+    epicsThreadOnce(&onceId, numaInit, nullptr);
+    // stores node + 1 (0 = not bound yet)
+    void *bound = reinterpret_cast<void *>(static_cast<size_t>(node + 1));
+    if (epicsThreadPrivateGet(boundKey) == bound)
+        return;
+    epicsThreadPrivateSet(boundKey, bound);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus(node))
+        CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set))
+        errlogPrintf("fftw: can't bind worker thread to NUMA node %d\n", node);
+#endif
+}
+
+bool
+FFTWNuma::bindMemory(void *p, const size_t len, const int node)
+{
+#ifdef __linux__
+    unsigned long mask[4] = {0, 0, 0, 0};
+    const size_t bits = 8 * sizeof(unsigned long);
+    if (node < 0 || static_cast<size_t>(node) >= 4 * bits)
+        return false;
+    mask[node / bits] = 1ul << (node % bits);
+    return syscall(__NR_mbind, p, len, MPOL_PREFERRED, mask, 4 * bits, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+size_t
+FFTWNuma::workerCount()
+{
+    size_t n = 0;
+    for (auto sched : schedulers())
+        n += sched->workerCount();
+    return n;
+}
+
+double
+FFTWNuma::busyTime()
+{
+    double busy = 0.0;
+    for (auto sched : schedulers())
+        busy += sched->busyTime();
+    return busy;
+}
+
+size_t
+FFTWNuma::pendingCount()
+{
+    size_t n = 0;
+    for (auto sched : schedulers())
+        n += sched->pendingCount();
+    return n;
+}
@@ -0,0 +1,61 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWNUMA_H
+#define FFTWNUMA_H
+
+#include <cstddef>
+#include <vector>
+
+class FFTWScheduler;
+
+// FFTWNuma
+// - NUMA topology (Linux sysfs), placement of instances on nodes
+// - the worker threads are partitioned: one pool per node with bound instances,
+//   its threads bound to the node's CPUs, the default pool gets the remaining CPUs
+// - memory policy for buffers of instances bound to a node
+
+class FFTWNuma
+{
+public:
+    // Number of NUMA nodes (1 if unknown or not supported)
+    static int nodes();
+
+    // Node for automatic placement: among the nodes with CPUs in the process' CPU set
+    // (inherited by the workers), the one with the fewest bound instances per CPU; -1 if none
+    static int autoNode();
+
+    // Scheduler for an instance bound to the node (created on first use), nullptr if not supported
+    static FFTWScheduler *scheduler(const int node);
+
+    // An instance bound to the node moves away
+    static void release(const int node);
+
+    // Worker threads of the pool of a node (its CPUs, at most one per bound instance)
+    // or of the default pool (node < 0: the CPUs not used by node pools, at least one)
+    static unsigned int threads(const int node);
+
+    // Bind the calling thread to the CPUs of the node (once per thread)
+    static void bindThread(const int node);
+
+    // Prefer the node for the pages of a (page aligned) buffer
+    static bool bindMemory(void *p, const size_t len, const int node);
+
+    // Sums over the node pools
+    static size_t workerCount();
+    static double busyTime();
+    static size_t pendingCount();
+
+private:
+    // CPUs of the node that are in the process' CPU set
+    static std::vector<int> cpus(const int node);
+};
+
+#endif // FFTWNUMA_H
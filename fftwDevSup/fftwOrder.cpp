@@ -0,0 +1,126 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "fftwOrder.h"
+
+namespace {
+// period change (relative, i.e. in revolutions at its end) that keeps the offsets of a revolution
+const double STABLE = 1e-4;
+// hysteresis of the edge detection (fraction of the tach amplitude)
+const double HYST = 0.1;
+}
+
+FFTWOrder::FFTWOrder()
+    : spr(64)
+    , ppr(1)
+    , level(NAN)
+    , nbuilds(0)
+{}
+
+void
+FFTWOrder::configure(const size_t samples, const size_t pulses, const double lvl)
+{
+    spr = samples ? samples : 64;
+    ppr = pulses ? pulses : 1;
+    level = lvl;
+    edges.clear();
+    periods.clear();
+    offsets.clear();
+}
+
+bool
+FFTWOrder::setTach(const double *tach, const size_t n)
+{
+    if (n < 2)
+        return false;
+
+    const auto mm = std::minmax_element(tach, tach + n);
+    const double amp = *mm.second - *mm.first;
+    const double thr = std::isnan(level) ? *mm.first + 0.5 * amp : level;
+    const double rearm = thr - HYST * amp;
+
+    // rising edges, every ppr-th one starts a revolution
+    std::vector<double> found;
+    bool armed = tach[0] < rearm;
+    size_t pulse = 0;
+    for (size_t i = 1; i < n; i++) {
+        if (!armed) {
+            armed = tach[i] < rearm;
+            continue;
+        }
+        if (tach[i - 1] < thr && tach[i] >= thr) {
+            armed = false;
+            if (pulse++ % ppr == 0)
+                found.push_back(i - 1 + (thr - tach[i - 1]) / (tach[i] - tach[i - 1]));
+        }
+    }
+    if (found.size() < 2)
+        return false;
+
+    edges.swap(found);
+    build();
+    return true;
+}
+
+void
+FFTWOrder::build()
+{
+    // the offsets depend on the period only, not on where the revolution starts
+    const size_t revs = revolutions();
+    periods.resize(revs, 0.0);
+    offsets.resize(revs * spr);
+    for (size_t r = 0; r < revs; r++) {
+        const double period = edges[r + 1] - edges[r];
+        if (std::fabs(period - periods[r]) <= STABLE * period)
+            continue;
+        periods[r] = period;
+        const double step = period / spr;
+        double *off = offsets.data() + r * spr;
+        for (size_t j = 0; j < spr; j++)
+            off[j] = j * step;
+        nbuilds++;
+    }
+}
+
+size_t
+FFTWOrder::average(const double *x, const size_t n, double *out) const
+{
+    // revolutions that lie within x
+    size_t revs = n > 1 ? revolutions() : 0;
+    while (revs && edges[revs] >= n - 1)
+        revs--;
+
+    std::fill(out, out + spr, 0.0);
+    if (!revs)
+        return 0;
+
+    const double scale = 1.0 / revs;
+    for (size_t r = 0; r < revs; r++) {
+        const double start = edges[r];
+        const double *off = offsets.data() + r * spr;
+        for (size_t j = 0; j < spr; j++) {
+            const double t = start + off[j];
+            const double i = std::floor(t);
+            const double a = x[static_cast<size_t>(i)];
+            out[j] += (a + (x[static_cast<size_t>(i) + 1] - a) * (t - i)) * scale;
+        }
+    }
+    return revs;
+}
+
+double
+FFTWOrder::period() const
+{
+    const size_t revs = revolutions();
+    return revs ? (edges[revs] - edges[0]) / revs : 0.0;
+}
@@ -0,0 +1,63 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWORDER_H
+#define FFTWORDER_H
+
+#include <cstddef>
+#include <vector>
+
+// FFTWOrder
+// - revolutions from a tachometer pulse train (rising edges, interpolated between samples)
+// - resampling table to a constant number of samples per revolution (linear interpolation):
+//   sample offsets from the start of each revolution, kept while its period stays the same
+//   (within a relative tolerance), a new tach signal only moves the revolution starts
+// - time-synchronous average of the revolutions of a waveform (sampled with the tach)
+
+class FFTWOrder
+{
+public:
+    FFTWOrder();
+
+    // Samples per revolution, pulses per revolution, threshold (NaN = halfway between min and max)
+    void configure(const size_t spr, const size_t ppr, const double level);
+
+    size_t samplesPerRev() const {return spr;}
+    size_t pulsesPerRev() const {return ppr;}
+    double threshold() const {return level;}
+
+    // Find the revolutions in a tach signal (n samples), false if there is no complete revolution
+    bool setTach(const double *tach, const size_t n);
+
+    // Average the revolutions of x (n samples) into out (spr samples), number of revolutions used
+    size_t average(const double *x, const size_t n, double *out) const;
+
+    // Revolutions in the latest tach signal, mean revolution length [samples]
+    size_t revolutions() const {return edges.size() > 1 ? edges.size() - 1 : 0;}
+    double period() const;
+
+    // Number of times a revolution of the resampling table was (re)built
+    size_t rebuilds() const {return nbuilds;}
+
+private:
+    size_t spr, ppr;
+    double level;
+
+    // Revolution boundaries [samples]
+    std::vector<double> edges;
+    // Per revolution: period the offsets were built for, offset of each resampled point [samples]
+    std::vector<double> periods;
+    std::vector<double> offsets;
+    size_t nbuilds;
+
+    void build();
+};
+
+#endif // FFTWORDER_H
@@ -0,0 +1,122 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <memory>
+
+#include <epicsAtomic.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsThreadPool.h>
+
+#include "fftwParallel.h"
+
+int FFTWParallelThreshold = 262144;
+
+namespace {
+
+epicsThreadOnceId onceId = EPICS_THREAD_ONCE_INIT;
+epicsThreadPool *helperPool;
+epicsThreadPoolConfig helperConfig;
+
+void
+helperInit(void *)
+{
+    epicsThreadPoolConfigDefaults(&helperConfig);
+    helperPool = epicsThreadPoolCreate(&helperConfig);
+}
+
+// Shared by the caller and the helpers, alive until the last helper is done with it
+struct Work
+{
+    std::function<void(size_t, size_t)> body;
+    size_t n, nchunks;
+    size_t next, done;
+    epicsEvent finished;
+};
+
+struct Helper
+{
+    std::shared_ptr<Work> work;
+    epicsJob *job;
+};
+
+// Take chunks until none are left
+void
+runChunks(Work &w)
+{
+    size_t c;
+    while ((c = epicsAtomicIncrSizeT(&w.next) - 1) < w.nchunks) {
+        const size_t begin = c * FFTWParallel::chunkSize;
+        w.body(begin, std::min(begin + FFTWParallel::chunkSize, w.n));
+        if (epicsAtomicIncrSizeT(&w.done) == w.nchunks)
+            w.finished.signal();
+    }
+}
+
+void
+helperJob(void *arg, epicsJobMode mode)
+{
+    auto helper = static_cast<Helper *>(arg);
+    if (mode == epicsJobModeRun)
+        runChunks(*helper->work);
+    epicsJobDestroy(helper->job);
+    delete helper;
+}
+
+} // namespace
+
+unsigned int
+FFTWParallel::helpers()
+{
+    epicsThreadOnce(&onceId, helperInit, nullptr);
+    return helperPool ? helperConfig.maxThreads : 0;
+}
+
+void
+FFTWParallel::forEach(const size_t n, const std::function<void(size_t, size_t)> &body)
+{
+    const size_t nchunks = (n + chunkSize - 1) / chunkSize;
+    if (FFTWParallelThreshold <= 0 || n < static_cast<size_t>(FFTWParallelThreshold) || nchunks < 2 || !helpers()) {
+        body(0, n);
+        return;
+    }
+
+    std::shared_ptr<Work> work(new Work);
+    work->body = body;
+    work->n = n;
+    work->nchunks = nchunks;
+    work->next = work->done = 0;
+
+    // helpers that start after all chunks are taken just return
+    const size_t ntasks = std::min<size_t>(nchunks - 1, helpers());
+    for (size_t i = 0; i < ntasks; i++) {
+        Helper *helper = new Helper;
+        helper->work = work;
+        helper->job = epicsJobCreate(helperPool, helperJob, helper);
+        if (!helper->job || epicsJobQueue(helper->job)) {
+            if (helper->job)
+                epicsJobDestroy(helper->job);
+            delete helper;
+            break;
+        }
+    }
+
+    runChunks(*work);
+    // wait for the chunks still running in helpers
+    while (epicsAtomicGetSizeT(&work->done) < nchunks)
+        work->finished.wait();
+}
+
+#include <epicsExport.h>
+
+extern "C" {
+epicsExportAddress(int, FFTWParallelThreshold);
+}
@@ -0,0 +1,39 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWPARALLEL_H
+#define FFTWPARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+extern int FFTWParallelThreshold;
+
+// FFTWParallel
+// - parallel-for over cache sized chunks, used for the post-processing of large spectra
+// - chunks are taken from a shared counter: the calling worker and any helper that
+//   has started pick up the next free chunk
+// - helpers run in their own pool, so that a busy instance pool can't block them
+// - below FFTWParallelThreshold elements (or with 0) the loop runs serially
+
+class FFTWParallel
+{
+public:
+    // Elements per chunk (four 16k arrays of doubles fit a typical L2 cache)
+    static const size_t chunkSize = 16384;
+
+    // Run body(begin, end) over [0, n), returns when all chunks are done
+    static void forEach(const size_t n, const std::function<void(size_t, size_t)> &body);
+
+    // Number of helper threads
+    static unsigned int helpers();
+};
+
+#endif // FFTWPARALLEL_H
@@ -0,0 +1,151 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "fftwNames.h"
+#include "fftwPeaks.h"
+
+namespace {
+
+inline double
+power(const fftw_complex &c)
+{
+    return c[0] * c[0] + c[1] * c[1];
+}
+
+// Sum of the power in bins [from, to)
+double
+bandPower(const fftw_complex *res, size_t from, size_t to)
+{
+    double p = 0.0;
+    for (size_t i = from; i < to; i++)
+        p += power(res[i]);
+    return p;
+}
+
+} // namespace
+
+bool
+FFTWPeaks::parse(const std::string &name, Quantity &q)
+{
+    return parseName(name, NQuantities, QuantityName, q);
+}
+
+bool
+FFTWPeaks::parse(const std::string &name, Figure &f)
+{
+    return parseName(name, NFigures, FigureName, f);
+}
+
+FFTWPeaks::Result::Result()
+{
+    for (int i = 0; i < NFigures; i++)
+        figure[i] = 0.0;
+}
+
+FFTWPeaks::FFTWPeaks()
+    : npeaks(5)
+    , interp(Parabolic)
+    , nharm(10)
+    , spread(3)
+{}
+
+void
+FFTWPeaks::interpolate(const fftw_complex *res, const size_t i, double &delta, double &magn) const
+{
+    const double ma = sqrt(power(res[i - 1]));
+    const double mb = sqrt(power(res[i]));
+    const double mc = sqrt(power(res[i + 1]));
+    const bool logs = interp == Gaussian && ma > 0.0 && mb > 0.0 && mc > 0.0;
+    const double a = logs ? log(ma) : ma;
+    const double b = logs ? log(mb) : mb;
+    const double c = logs ? log(mc) : mc;
+    const double den = a - 2.0 * b + c;
+    delta = den != 0.0 ? 0.5 * (a - c) / den : 0.0;
+    const double peak = b - 0.25 * (a - c) * delta;
+    magn = logs ? exp(peak) : peak;
+}
+
+size_t
+FFTWPeaks::find(const fftw_complex *res, const size_t n, const double *fscale, const double wsum,
+                double *freq, double *ampl, double *phas, double *fbin) const
+{
+    if (n < 3 || !npeaks)
+        return 0;
+
+    // candidates (power, bin), the smallest one on top of the heap
+    typedef std::pair<double, size_t> Cand;
+    std::vector<Cand> top;
+    top.reserve(npeaks + 1);
+    double prev = power(res[0]), curr = power(res[1]);
+    for (size_t i = 1; i + 1 < n; i++) {
+        const double next = power(res[i + 1]);
+        if (curr > prev && curr >= next && (top.size() < npeaks || curr > top.front().first)) {
+            top.push_back(Cand(curr, i));
+            std::push_heap(top.begin(), top.end(), std::greater<Cand>());
+            if (top.size() > npeaks) {
+                std::pop_heap(top.begin(), top.end(), std::greater<Cand>());
+                top.pop_back();
+            }
+        }
+        prev = curr;
+        curr = next;
+    }
+    std::sort_heap(top.begin(), top.end(), std::greater<Cand>());
+
+    // amplitude of a sine: two sided spectrum, window gain
+    const double scale = wsum > 0.0 ? 2.0 / wsum : 0.0;
+    for (size_t k = 0; k < top.size(); k++) {
+        const size_t i = top[k].second;
+        double delta, magn;
+        interpolate(res, i, delta, magn);
+        const double step = delta >= 0.0 ? fscale[i + 1] - fscale[i] : fscale[i] - fscale[i - 1];
+        freq[k] = fscale[i] + delta * step;
+        ampl[k] = magn * scale;
+        phas[k] = atan2(res[i][1], res[i][0]);
+        if (k == 0 && fbin)
+            *fbin = i + delta;
+    }
+    return top.size();
+}
+
+void
+FFTWPeaks::harmonics(const fftw_complex *res, const size_t n, const double fbin, double *figure) const
+{
+    const double tiny = 1e-300;
+    const size_t lo = spread + 1; // DC and its leakage are excluded
+
+    double total = bandPower(res, std::min(lo, n), n);
+    double fund = 0.0, harm = 0.0;
+    for (size_t h = 1; h <= std::max<size_t>(nharm, 1); h++) {
+        const double pos = h * fbin + 0.5;
+        if (pos >= n)
+            break;
+        const size_t c = static_cast<size_t>(pos);
+        const size_t from = std::max(c > spread ? c - spread : 0, lo);
+        const size_t to = std::min(c + spread + 1, n);
+        if (from >= to)
+            continue;
+        const double p = bandPower(res, from, to);
+        if (h == 1)
+            fund = p;
+        else
+            harm += p;
+    }
+    const double noise = std::max(total - fund - harm, tiny);
+
+    figure[THD] = 10.0 * log10(std::max(harm, tiny) / std::max(fund, tiny));
+    figure[SNR] = 10.0 * log10(std::max(fund, tiny) / noise);
+    figure[SINAD] = 10.0 * log10(std::max(fund, tiny) / (noise + harm));
+    figure[ENOB] = (figure[SINAD] - 1.76) / 6.02;
+}
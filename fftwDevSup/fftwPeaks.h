@@ -0,0 +1,119 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWPEAKS_H
+#define FFTWPEAKS_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fftw3.h>
+
+// FFTWPeaks
+// - top-N local maxima of a spectrum, sub-bin frequency and amplitude by interpolation
+//   over the neighbouring bins (parabolic on the magnitude or Gaussian on its log)
+// - harmonic analysis of the largest peak (fundamental): THD, SNR, SINAD, ENOB
+
+class FFTWPeaks
+{
+public:
+    enum Quantity {
+        Freq = 0,
+        Ampl,
+        Phas,
+        NQuantities
+    };
+
+    static inline const char *
+    QuantityName(const Quantity q)
+    {
+        switch (q) {
+        case Freq:
+            return "freq";
+        case Ampl:
+            return "ampl";
+        case Phas:
+            return "phas";
+        case NQuantities:
+            break;
+        }
+        return "?";
+    }
+
+    enum Figure {
+        Fund = 0,
+        THD,
+        SNR,
+        SINAD,
+        ENOB,
+        NFigures
+    };
+
+    static inline const char *
+    FigureName(const Figure f)
+    {
+        switch (f) {
+        case Fund:
+            return "fund";
+        case THD:
+            return "thd";
+        case SNR:
+            return "snr";
+        case SINAD:
+            return "sinad";
+        case ENOB:
+            return "enob";
+        case NFigures:
+            break;
+        }
+        return "?";
+    }
+
+    enum Interp {
+        Parabolic = 0,
+        Gaussian
+    };
+
+    // Parse quantity / figure names, false if unknown
+    static bool parse(const std::string &name, Quantity &q);
+    static bool parse(const std::string &name, Figure &f);
+
+    // Results of one channel
+    struct Result
+    {
+        Result();
+        std::shared_ptr<std::vector<double>> value[NQuantities];
+        double figure[NFigures];
+    };
+
+    FFTWPeaks();
+
+    size_t npeaks;  // number of peaks
+    Interp interp;
+    size_t nharm;   // highest harmonic counted for THD
+    size_t spread;  // bins on each side of a line that belong to it
+
+    // Find the peaks of res (n bins at frequencies fscale, window sum wsum for the amplitude)
+    // and write their frequency, amplitude and phase (largest first), returns the number found
+    // fbin: bin position (fractional) of the largest peak
+    size_t find(const fftw_complex *res, const size_t n, const double *fscale, const double wsum,
+                double *freq, double *ampl, double *phas, double *fbin = nullptr) const;
+
+    // Harmonic analysis with the fundamental at bin position fbin (fractional), figure[Fund] is not set
+    void harmonics(const fftw_complex *res, const size_t n, const double fbin, double *figure) const;
+
+private:
+    // Interpolated position offset (-0.5..0.5) and magnitude at a local maximum
+    void interpolate(const fftw_complex *res, const size_t i, double &delta, double &magn) const;
+};
+
+#endif // FFTWPEAKS_H
@@ -0,0 +1,201 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <errlog.h>
+
+#ifdef __linux__
+#    include <linux/perf_event.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+#include "fftwPerf.h"
+
+int FFTWPerf::enabled;
+
+namespace {
+
+#ifdef __linux__
+
+// Counter group of one thread
+struct Group
+{
+    bool ok;
+    int leader;
+    int fd[FFTWPerf::NCounters];
+    int pos[FFTWPerf::NCounters]; // position in the group read, -1 = not supported
+    int n;
+};
+
+epicsThreadOnceId onceId = EPICS_THREAD_ONCE_INIT;
+epicsThreadPrivateId groupKey;
+
+void
+perfInit(void *)
+{
+    groupKey = epicsThreadPrivateCreate();
+}
+
+int
+perfOpen(const __u32 type, const __u64 config, const int group)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // counting this thread on any CPU
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+// Counter group of the calling thread, opened on first use
+Group *
+threadGroup()
+{
+    epicsThreadOnce(&onceId, perfInit, nullptr);
+    auto g = static_cast<Group *>(epicsThreadPrivateGet(groupKey));
+    if (g)
+        return g;
+
+    g = new Group;
+    g->n = 0;
+    for (int i = 0; i < FFTWPerf::NCounters; i++) {
+        g->fd[i] = -1;
+        g->pos[i] = -1;
+    }
+
+    g->leader = g->fd[FFTWPerf::Cycles] = perfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+    const int err = errno;
+    g->ok = g->leader >= 0;
+    if (g->ok) {
+        g->pos[FFTWPerf::Cycles] = g->n++;
+        g->fd[FFTWPerf::Instructions] = perfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, g->leader);
+        g->fd[FFTWPerf::LLCMisses] = perfOpen(PERF_TYPE_HW_CACHE,
+                                              PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                                              g->leader);
+        if (g->fd[FFTWPerf::LLCMisses] < 0)
+            g->fd[FFTWPerf::LLCMisses] = perfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, g->leader);
+        g->fd[FFTWPerf::StalledCycles]
+            = perfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND, g->leader);
+        for (int i = FFTWPerf::Instructions; i < FFTWPerf::NCounters; i++)
+            if (g->fd[i] >= 0)
+                g->pos[i] = g->n++;
+    } else {
+        const char *name = epicsThreadGetNameSelf();
+        errlogPrintf("fftw: hardware counters not available in thread %s (%s), "
+                     "check /proc/sys/kernel/perf_event_paranoid\n",
+                     name ? name : "?",
+                     strerror(err));
+    }
+    epicsThreadPrivateSet(groupKey, g);
+    return g;
+}
+
+#endif // __linux__
+
+} // namespace
+
+bool
+FFTWPerf::enable(bool on)
+{
+    if (!on) {
+        enabled = 0;
+        return true;
+    }
+#ifdef __linux__
+    // probe on the calling thread
+    if (!threadGroup()->ok)
+        return false;
+    enabled = 1;
+    return true;
+#else
+    errlogPrintf("fftw: hardware counters are only supported on Linux\n");
+    return false;
+#endif
+}
+
+bool
+FFTWPerf::read(Sample &s)
+{
+#ifdef __linux__
+    Group *g = threadGroup();
+    if (!g->ok) {
+        // the kernel refused access: fall back to no counters
+        enabled = 0;
+        return false;
+    }
+    __u64 buf[3 + NCounters];
+    if (::read(g->leader, buf, sizeof(buf)) < static_cast<ssize_t>((3 + g->n) * sizeof(__u64)))
+        return false;
+    s.tenabled = static_cast<double>(buf[1]);
+    s.trunning = static_cast<double>(buf[2]);
+    for (int i = 0; i < NCounters; i++)
+        s.value[i] = g->pos[i] < 0 ? -1.0 : static_cast<double>(buf[3 + g->pos[i]]);
+    return true;
+#else
+    return false;
+#endif
+}
+
+FFTWPerf::Section::Section()
+    : count(0)
+{
+    for (int i = 0; i < NCounters; i++)
+        sum[i] = 0.0;
+}
+
+void
+FFTWPerf::Section::add(const Sample &start, const Sample &stop)
+{
+    // the group was multiplexed out for part of the section: values are not usable
+    if (stop.tenabled - start.tenabled != stop.trunning - start.trunning)
+        return;
+
+    epicsGuard<epicsMutex> G(lock);
+    count++;
+    for (int i = 0; i < NCounters; i++) {
+        if (start.value[i] < 0.0 || sum[i] < 0.0)
+            sum[i] = -1.0;
+        else
+            sum[i] += stop.value[i] - start.value[i];
+    }
+}
+
+void
+FFTWPerf::Section::show(const char *label, const unsigned char indent) const
+{
+    epicsGuard<epicsMutex> G(lock);
+    std::string ind(indent, ' ');
+    std::cout << "\n" << ind << label << ": " << count << " runs";
+    if (!count)
+        return;
+    for (int i = 0; i < NCounters; i++) {
+        std::cout << ", " << CounterName(static_cast<Counter>(i)) << " ";
+        if (sum[i] < 0.0)
+            std::cout << "n/a";
+        else
+            std::cout << sum[i] / count;
+    }
+    if (sum[Cycles] > 0.0 && sum[Instructions] >= 0.0)
+        std::cout << ", IPC " << sum[Instructions] / sum[Cycles];
+    if (sum[Cycles] > 0.0 && sum[StalledCycles] >= 0.0)
+        std::cout << ", stalled " << 100.0 * sum[StalledCycles] / sum[Cycles] << "%";
+}
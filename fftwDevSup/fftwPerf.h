@@ -0,0 +1,98 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWPERF_H
+#define FFTWPERF_H
+
+#include <epicsMutex.h>
+
+// FFTWPerf
+// - optional hardware performance counters (Linux perf_event_open)
+// - one counter group per worker thread, opened on first use
+// - read around the transform and the post-processing, summed per instance
+// - switched off (with a message) if the kernel refuses access
+
+class FFTWPerf
+{
+public:
+    enum Counter {
+        Cycles = 0,
+        Instructions,
+        LLCMisses,
+        StalledCycles,
+        NCounters
+    };
+
+    static inline const char *
+    CounterName(const Counter c)
+    {
+        switch (c) {
+        case Cycles:
+            return "cycles";
+        case Instructions:
+            return "instructions";
+        case LLCMisses:
+            return "LLC-misses";
+        case StalledCycles:
+            return "stalled-cycles";
+        case NCounters:
+            break;
+        }
+        return "?";
+    }
+
+    // Counter switch: checked before anything else, no cost when off
+    static int enabled;
+
+    // Switch counters on or off, false if they are not available
+    static bool enable(bool on);
+
+    // Counter values of the calling thread
+    struct Sample
+    {
+        bool valid;
+        double tenabled, trunning; // time the group was enabled / counting [ns]
+        double value[NCounters];
+    };
+
+    // Counter sums of one measured code section
+    class Section
+    {
+    public:
+        Section();
+        void add(const Sample &start, const Sample &stop);
+        // Print averages per run
+        void show(const char *label, const unsigned char indent = 0) const;
+
+    private:
+        mutable epicsMutex lock;
+        unsigned long count;
+        double sum[NCounters]; // < 0: counter not supported
+    };
+
+    static inline void
+    start(Sample &s)
+    {
+        s.valid = enabled && read(s);
+    }
+
+    static inline void
+    stop(const Sample &start, Section &section)
+    {
+        Sample s;
+        if (start.valid && read(s))
+            section.add(start, s);
+    }
+
+private:
+    static bool read(Sample &s);
+};
+
+#endif // FFTWPERF_H
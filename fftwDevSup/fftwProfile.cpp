@@ -0,0 +1,93 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "fftwNames.h"
+#include "fftwProfile.h"
+
+bool
+FFTWProfile::parse(const std::string &name, Kind &k)
+{
+    return parseName(name, NKinds, KindName, k);
+}
+
+size_t
+FFTWProfile::size(const Kind k, const size_t rows, const size_t cols)
+{
+    switch (k) {
+    case Radial:
+        return std::max(rows, cols) / 2 + 1;
+    case Rows:
+        return rows;
+    case Cols:
+        return cols / 2 + 1;
+    default:
+        return 0;
+    }
+}
+
+void
+FFTWProfile::calculate(const Kind k, const fftw_complex *res, const size_t rows, const size_t cols, double *out)
+{
+    const size_t F = cols / 2 + 1;
+    const size_t n = size(k, rows, cols);
+    std::fill(out, out + n, 0.0);
+
+    // columns 1 .. (cols-1)/2 stand for two bins of the full spectrum: (r, c) and (-r, -c)
+    auto mirrored = [=](size_t c) {return c > 0 && 2 * c != cols;};
+
+    switch (k) {
+    case Radial: {
+        const double scale = static_cast<double>(std::max(rows, cols));
+        std::vector<double> count(n, 0.0);
+        for (size_t r = 0; r < rows; r++) {
+            const double fr = (r <= rows / 2 ? double(r) : double(r) - rows) / rows;
+            for (size_t c = 0; c < F; c++) {
+                const double fc = double(c) / cols;
+                const size_t ring = static_cast<size_t>(std::lround(std::sqrt(fr * fr + fc * fc) * scale));
+                if (ring >= n)
+                    continue;
+                const double w = mirrored(c) ? 2.0 : 1.0;
+                const fftw_complex &v = res[r * F + c];
+                out[ring] += w * std::sqrt(v[0] * v[0] + v[1] * v[1]);
+                count[ring] += w;
+            }
+        }
+        for (size_t i = 0; i < n; i++)
+            if (count[i] > 0.0)
+                out[i] /= count[i];
+        break;
+    }
+    case Rows:
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t c = 0; c < F; c++) {
+                const fftw_complex &v = res[r * F + c];
+                const double m = std::sqrt(v[0] * v[0] + v[1] * v[1]);
+                out[r] += m;
+                if (mirrored(c))
+                    out[(rows - r) % rows] += m;
+            }
+        }
+        break;
+    case Cols:
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t c = 0; c < F; c++) {
+                const fftw_complex &v = res[r * F + c];
+                out[c] += std::sqrt(v[0] * v[0] + v[1] * v[1]);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
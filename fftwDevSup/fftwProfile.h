@@ -0,0 +1,60 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWPROFILE_H
+#define FFTWPROFILE_H
+
+#include <cstddef>
+#include <string>
+
+#include <fftw3.h>
+
+// FFTWProfile
+// - profiles of the magnitude of a 2D spectrum (rows x (cols/2+1) bins of an r2c transform)
+// - radial: mean over rings of width 1/max(rows, cols) cycles per pixel, up to the Nyquist frequency
+// - rows, cols: sum over the other axis of the full spectrum (missing half from the symmetry)
+
+class FFTWProfile
+{
+public:
+    enum Kind {
+        Radial = 0,
+        Rows,
+        Cols,
+        NKinds
+    };
+
+    static inline const char *
+    KindName(const Kind k)
+    {
+        switch (k) {
+        case Radial:
+            return "radial";
+        case Rows:
+            return "rows";
+        case Cols:
+            return "cols";
+        case NKinds:
+            break;
+        }
+        return "?";
+    }
+
+    // Parse a profile name, false if unknown
+    static bool parse(const std::string &name, Kind &k);
+
+    // Number of values of a profile of a rows x cols image
+    static size_t size(const Kind k, const size_t rows, const size_t cols);
+
+    // Calculate a profile (size() values) from the spectrum of a rows x cols image
+    static void calculate(const Kind k, const fftw_complex *res, const size_t rows, const size_t cols, double *out);
+};
+
+#endif // FFTWPROFILE_H
@@ -0,0 +1,161 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "fftwReduce.h"
+
+FFTWReduce::FFTWReduce(const Op op, const Layout layout, const size_t nbins)
+    : op(op)
+    , layout(layout)
+    , nbins(nbins)
+    , nin(0)
+{}
+
+FFTWReduce *
+FFTWReduce::create(const std::string &spec)
+{
+    const size_t colon = spec.find(':');
+    if (colon == std::string::npos)
+        return nullptr;
+
+    const std::string o = spec.substr(0, colon);
+    const std::string l = spec.substr(colon + 1);
+    Op op;
+    if (o == "max")
+        op = Max;
+    else if (o == "mean")
+        op = Mean;
+    else
+        return nullptr;
+
+    if (l == "oct")
+        return new FFTWReduce(op, Octave, 0);
+    if (l == "oct3")
+        return new FFTWReduce(op, ThirdOctave, 0);
+
+    Layout layout = Linear;
+    std::string count = l;
+    if (l.compare(0, 3, "log") == 0) {
+        layout = Log;
+        count = l.substr(3);
+    }
+    unsigned long n = 0;
+    try {
+        n = std::stoul(count);
+    } catch (std::exception &e) {
+        return nullptr;
+    }
+    if (!n)
+        return nullptr;
+    return new FFTWReduce(op, layout, n);
+}
+
+std::string
+FFTWReduce::spec() const
+{
+    std::ostringstream s;
+    s << (op == Max ? "max:" : "mean:");
+    switch (layout) {
+    case Linear:
+        s << nbins;
+        break;
+    case Log:
+        s << "log" << nbins;
+        break;
+    case Octave:
+        s << "oct";
+        break;
+    case ThirdOctave:
+        s << "oct3";
+        break;
+    }
+    return s.str();
+}
+
+void
+FFTWReduce::addBand(const double *fscale, const size_t n, const double flo, const double fhi, const double fc)
+{
+    const size_t b = std::lower_bound(fscale, fscale + n, flo) - fscale;
+    const size_t e = std::lower_bound(fscale, fscale + n, fhi) - fscale;
+    if (e > b) {
+        bands.push_back(std::make_pair(b, e));
+        center.push_back(fc);
+    }
+}
+
+void
+FFTWReduce::build(const double *fscale, const size_t n)
+{
+    bands.clear();
+    center.clear();
+    nin = n;
+    if (!n)
+        return;
+
+    if (layout == Linear) {
+        const size_t nb = std::min(nbins, n);
+        for (size_t j = 0; j < nb; j++) {
+            const size_t b = j * n / nb;
+            const size_t e = (j + 1) * n / nb;
+            bands.push_back(std::make_pair(b, e));
+            center.push_back(0.5 * (fscale[b] + fscale[e - 1]));
+        }
+        return;
+    }
+
+    // log scales start at the first positive frequency (DC is dropped)
+    const size_t first = std::upper_bound(fscale, fscale + n, 0.0) - fscale;
+    if (first >= n)
+        return;
+    const double fmin = fscale[first];
+    // the last bin is included
+    const double fmax = n > first + 1 ? fscale[n - 1] + 0.5 * (fscale[n - 1] - fscale[n - 2]) : 2.0 * fmin;
+
+    if (layout == Log) {
+        const double ratio = pow(fmax / fmin, 1.0 / nbins);
+        double flo = fmin;
+        for (size_t j = 0; j < nbins; j++) {
+            const double fhi = j + 1 == nbins ? fmax : flo * ratio;
+            addBand(fscale, n, flo, fhi, sqrt(flo * fhi));
+            flo = fhi;
+        }
+        return;
+    }
+
+    // octave bands: centers 1 kHz * 2^(k/b), edges at 2^(+/- 1/2b)
+    const double b = layout == Octave ? 1.0 : 3.0;
+    const double half = pow(2.0, 0.5 / b);
+    const int kmin = static_cast<int>(floor(b * log2(fmin / 1000.0)));
+    const int kmax = static_cast<int>(ceil(b * log2(fmax / 1000.0)));
+    for (int k = kmin; k <= kmax; k++) {
+        const double fc = 1000.0 * pow(2.0, k / b);
+        addBand(fscale, n, std::max(fc / half, fmin), std::min(fc * half, fmax), fc);
+    }
+}
+
+void
+FFTWReduce::apply(const double *in, double *out) const
+{
+    for (size_t j = 0; j < bands.size(); j++) {
+        const double *b = in + bands[j].first;
+        const double *e = in + bands[j].second;
+        if (op == Max) {
+            out[j] = *std::max_element(b, e);
+        } else {
+            double sum = 0.0;
+            for (const double *p = b; p < e; p++)
+                sum += *p;
+            out[j] = sum / (e - b);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWREDUCE_H
+#define FFTWREDUCE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// FFTWReduce
+// - reduction of an output spectrum to fewer bins for display clients
+// - bands: linear (target bin count), log-spaced, 1/1 or 1/3 octave (base 2, centered at 1 kHz)
+// - each band is the maximum (keeps peaks) or the mean of its bins
+// - the band table is built from the frequency scale and kept until the scale changes
+
+class FFTWReduce
+{
+public:
+    enum Op {
+        Max = 0,
+        Mean
+    };
+
+    enum Layout {
+        Linear = 0,
+        Log,
+        Octave,
+        ThirdOctave
+    };
+
+    // Parse "<op>:<layout>" (e.g. "max:2000", "mean:log500", "max:oct3"), nullptr if illegal
+    static FFTWReduce *create(const std::string &spec);
+
+    // Rebuild the band table for a frequency scale
+    void build(const double *fscale, const size_t n);
+
+    // Input size of the current table (0 = not built)
+    size_t inputSize() const {return nin;}
+
+    // Number of bands
+    size_t size() const {return bands.size();}
+
+    // Band center frequencies
+    const std::vector<double> &centers() const {return center;}
+
+    // Reduce n = inputSize() values to size() values
+    void apply(const double *in, double *out) const;
+
+    std::string spec() const;
+
+private:
+    FFTWReduce(const Op op, const Layout layout, const size_t nbins);
+
+    Op op;
+    Layout layout;
+    size_t nbins;
+
+    size_t nin;
+    std::vector<std::pair<size_t, size_t>> bands; // [begin, end) of each band
+    std::vector<double> center;
+
+    // Add the band of frequencies [flo, fhi) if it contains bins
+    void addBand(const double *fscale, const size_t n, const double flo, const double fhi, const double fc);
+};
+
+#endif // FFTWREDUCE_H
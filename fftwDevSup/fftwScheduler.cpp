@@ -0,0 +1,234 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <iostream>
+
+#include <epicsGuard.h>
+
+#include "fftwInstance.h"
+#include "fftwNuma.h"
+#include "fftwScheduler.h"
+#include "fftwTrace.h"
+
+FFTWScheduler::FFTWScheduler(const int node)
+    : pool(nullptr)
+    , node(node)
+    , seq(0)
+    , busy(0.0)
+{}
+
+// Jobs still owned by the pool are cleaned up through dispatchJob()
+FFTWScheduler::~FFTWScheduler()
+{
+    if (pool)
+        epicsThreadPoolDestroy(pool);
+}
+
+double
+FFTWScheduler::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+void
+FFTWScheduler::submit(FFTWInstance *inst)
+{
+    Guard G(lock);
+
+    if (inst->pending) {
+        // data of the new trigger will be picked up by the pending run
+        inst->nCoalesced++;
+        return;
+    }
+
+    inst->pending = true;
+    inst->trigtime = now();
+
+    Entry e;
+    e.inst = inst;
+    e.deadline = inst->deadline > 0.0 ? inst->trigtime + inst->deadline : 0.0;
+    e.seq = seq++;
+    pending.push_back(e);
+
+    // a running instance re-dispatches itself when done
+    if (!inst->running)
+        queueToken();
+}
+
+void
+FFTWScheduler::coalesced(FFTWInstance *inst)
+{
+    Guard G(lock);
+    inst->nCoalesced++;
+}
+
+FFTWScheduler::Counters
+FFTWScheduler::counters(const FFTWInstance *inst)
+{
+    Guard G(lock);
+    Counters c;
+    c.runs = inst->nRuns;
+    c.skipped = inst->nSkipped;
+    c.coalesced = inst->nCoalesced;
+    c.qlatSum = inst->qlatSum;
+    return c;
+}
+
+size_t
+FFTWScheduler::pendingCount()
+{
+    Guard G(lock);
+    return pending.size();
+}
+
+double
+FFTWScheduler::busyTime()
+{
+    Guard G(lock);
+    return busy;
+}
+
+size_t
+FFTWScheduler::workerCount()
+{
+    Guard G(lock);
+    if (pool)
+        return poolConfig.maxThreads;
+    return FFTWNuma::threads(node);
+}
+
+void
+FFTWScheduler::queueToken()
+{
+    if (!pool) {
+        // sized when the first calculation is queued, after the instances have been placed
+        epicsThreadPoolConfigDefaults(&poolConfig);
+        poolConfig.maxThreads = FFTWNuma::threads(node);
+        pool = epicsThreadPoolCreate(&poolConfig);
+        assert(pool != nullptr);
+    }
+    Token *token;
+    if (idle.empty()) {
+        token = new Token;
+        token->sched = this;
+        token->job = epicsJobCreate(pool, dispatchJob, token);
+        assert(token->job != nullptr);
+    } else {
+        token = idle.back();
+        idle.pop_back();
+    }
+    epicsJobQueue(token->job);
+}
+
+// Order: priority class, then earliest deadline (none = last), then trigger order
+static bool
+moreUrgent(const FFTWInstance *a, double da, unsigned long sa, const FFTWInstance *b, double db, unsigned long sb)
+{
+    if (a->priority != b->priority)
+        return a->priority < b->priority;
+    if (da != db) {
+        if (da == 0.0)
+            return false;
+        if (db == 0.0)
+            return true;
+        return da < db;
+    }
+    return sa < sb;
+}
+
+bool
+FFTWScheduler::pickNext(Entry &next)
+{
+    auto best = pending.end();
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        if (it->inst->running)
+            continue;
+        if (best == pending.end()
+            || moreUrgent(it->inst, it->deadline, it->seq, best->inst, best->deadline, best->seq))
+            best = it;
+    }
+    if (best == pending.end())
+        return false;
+    next = *best;
+    pending.erase(best);
+    return true;
+}
+
+void
+FFTWScheduler::dispatch(Token *token)
+{
+    Entry e;
+    double start;
+    bool skip = false;
+    {
+        Guard G(lock);
+        if (!pickNext(e)) {
+            idle.push_back(token);
+            return;
+        }
+        FFTWInstance *inst = e.inst;
+        inst->pending = false;
+        inst->running = true;
+
+        start = now();
+        inst->runTrigtime = inst->trigtime;
+        double latency = start - inst->trigtime;
+        inst->qlatLast = latency;
+        inst->qlatSum += latency;
+        if (latency > inst->qlatMax)
+            inst->qlatMax = latency;
+        inst->nRuns++;
+        inst->stats.add(FFTWStats::QueueWait, latency);
+
+        if (e.deadline > 0.0 && start > e.deadline && inst->skipLate) {
+            inst->nDeadlineMiss++;
+            inst->nSkipped++;
+            skip = true;
+        }
+    }
+
+    if (node >= 0)
+        FFTWNuma::bindThread(node);
+
+    PTimer jobtime;
+    if (skip) {
+        if (FFTWDebug)
+            std::cerr << "Skipping calculation for instance " << e.inst->name << " (deadline passed)" << std::endl;
+    } else {
+        if (FFTWDebug)
+            std::cerr << "Running calculation for instance " << e.inst->name << std::endl;
+        e.inst->calculate();
+        FFTWTrace::complete("job", e.inst->name.c_str(), jobtime.snap());
+    }
+
+    Guard G(lock);
+    FFTWInstance *inst = e.inst;
+    busy += jobtime.wall;
+    if (!skip && e.deadline > 0.0 && now() > e.deadline)
+        inst->nDeadlineMiss++;
+    inst->running = false;
+    idle.push_back(token);
+    if (inst->pending)
+        queueToken();
+}
+
+void
+FFTWScheduler::dispatchJob(void *arg, epicsJobMode mode)
+{
+    auto token = reinterpret_cast<Token *>(arg);
+    if (mode == epicsJobModeCleanup) {
+        epicsJobDestroy(token->job);
+        delete token;
+        return;
+    }
+    token->sched->dispatch(token);
+}
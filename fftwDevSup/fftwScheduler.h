@@ -0,0 +1,117 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWSCHEDULER_H
+#define FFTWSCHEDULER_H
+
+#include <vector>
+
+#include <epicsMutex.h>
+#include <epicsThreadPool.h>
+
+class FFTWInstance;
+
+// FFTWScheduler
+// - keeps the list of triggered (pending) instances
+// - orders them by priority class, deadline and trigger order
+// - dispatches them through interchangeable jobs of the worker pool
+
+class FFTWScheduler
+{
+public:
+    enum Priority {
+        High = 0,
+        Normal,
+        Low
+    };
+
+    static inline const char *
+    PriorityName(const Priority p)
+    {
+        switch (p) {
+        case High:
+            return "High";
+        case Normal:
+            return "Normal";
+        case Low:
+            return "Low";
+        }
+        return "?";
+    }
+
+    // node >= 0: workers bind themselves to the CPUs of that NUMA node
+    // (the worker pool is created on first use, sized by FFTWNuma::threads())
+    FFTWScheduler(const int node = -1);
+    ~FFTWScheduler();
+
+    // Queue a calculation for the instance (coalesced if already pending)
+    void submit(FFTWInstance *inst);
+
+    // Count a trigger whose data was replaced before it was calculated
+    void coalesced(FFTWInstance *inst);
+
+    // Run counters of an instance, copied under the lock
+    struct Counters
+    {
+        unsigned long runs, skipped, coalesced;
+        double qlatSum;
+    };
+    Counters counters(const FFTWInstance *inst);
+
+    // Number of pending (not yet started) calculations
+    size_t pendingCount();
+
+    // Accumulated wall clock time spent in calculations [s]
+    double busyTime();
+
+    // Number of worker threads (planned size until the pool is created)
+    size_t workerCount();
+
+    // Worker pool, nullptr before first use
+    epicsThreadPool *threadPool() const {return pool;}
+
+    // Monotonic time [s]
+    static double now();
+
+private:
+    struct Entry
+    {
+        FFTWInstance *inst;
+        double deadline;
+        unsigned long seq;
+    };
+    struct Token
+    {
+        FFTWScheduler *sched;
+        epicsJob *job;
+    };
+
+    epicsMutex lock;
+    epicsThreadPoolConfig poolConfig;
+    epicsThreadPool *pool;
+    int node;
+    std::vector<Entry> pending;
+    std::vector<Token *> idle;
+    unsigned long seq;
+    double busy;
+
+    // Queue one dispatch job (called with lock held)
+    void queueToken();
+
+    // Remove and return the most urgent runnable entry (called with lock held)
+    bool pickNext(Entry &next);
+
+    void dispatch(Token *token);
+
+    // epicsThreadPool interface
+    static void dispatchJob(void *arg, epicsJobMode mode);
+};
+
+#endif // FFTWSCHEDULER_H
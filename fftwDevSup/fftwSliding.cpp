@@ -0,0 +1,119 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "fftwSliding.h"
+
+static const double PI = 3.141592653589793;
+
+FFTWSliding::FFTWSliding()
+    : len(0)
+    , pos(0)
+    , sinceSync(0)
+{}
+
+void
+FFTWSliding::configure(const size_t n, const std::vector<double> &bins)
+{
+    if (n == len && bins == k)
+        return;
+
+    len = n;
+    k = bins;
+    const size_t nb = k.size();
+    cr.resize(nb);
+    ci.resize(nb);
+    dr.resize(nb);
+    di.resize(nb);
+    coef.resize(nb);
+    for (size_t j = 0; j < nb; j++) {
+        const double w = len ? 2.0 * PI * k[j] / len : 0.0;
+        cr[j] = cos(w);
+        ci[j] = sin(w);
+        dr[j] = cos(w * (len - 1.0));
+        di[j] = -sin(w * (len - 1.0));
+        coef[j] = 2.0 * cos(w);
+    }
+    reset();
+}
+
+void
+FFTWSliding::reset()
+{
+    hist.assign(len, 0.0);
+    sr.assign(k.size(), 0.0);
+    si.assign(k.size(), 0.0);
+    pos = sinceSync = 0;
+}
+
+void
+FFTWSliding::resync()
+{
+    const size_t nb = k.size();
+    for (size_t j = 0; j < nb; j++) {
+        const double c = coef[j];
+        double s1 = 0.0, s2 = 0.0;
+        for (size_t m = pos; m < len; m++) {
+            const double s = hist[m] + c * s1 - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        for (size_t m = 0; m < pos; m++) {
+            const double s = hist[m] + c * s1 - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        // y = s1 - exp(-i w) s2, X = exp(-i w (N-1)) y
+        const double yr = s1 - cr[j] * s2;
+        const double yi = ci[j] * s2;
+        sr[j] = dr[j] * yr - di[j] * yi;
+        si[j] = dr[j] * yi + di[j] * yr;
+    }
+    sinceSync = 0;
+}
+
+void
+FFTWSliding::update(const double *x, const size_t n, fftw_complex *out)
+{
+    const size_t nb = k.size();
+    if (!len)
+        return;
+
+    if (n >= len) {
+        // the block replaces the whole history
+        std::copy(x + n - len, x + n, hist.begin());
+        pos = 0;
+        resync();
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            const double old = hist[pos];
+            hist[pos] = x[i];
+            if (++pos == len)
+                pos = 0;
+            // X' = exp(i w) (X - x_old) + exp(-i w (N-1)) x_new
+            for (size_t j = 0; j < nb; j++) {
+                const double tr = sr[j] - old;
+                const double ti = si[j];
+                sr[j] = cr[j] * tr - ci[j] * ti + dr[j] * x[i];
+                si[j] = cr[j] * ti + ci[j] * tr + di[j] * x[i];
+            }
+        }
+        sinceSync += n;
+        if (sinceSync >= len)
+            resync();
+    }
+
+    for (size_t j = 0; j < nb; j++) {
+        out[j][0] = sr[j];
+        out[j][1] = si[j];
+    }
+}
@@ -0,0 +1,58 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWSLIDING_H
+#define FFTWSLIDING_H
+
+#include <cstddef>
+#include <vector>
+
+#include <fftw3.h>
+
+// FFTWSliding
+// - DFT of the latest N samples at a few selected (possibly fractional) bins
+// - recursive sliding DFT over the new samples of each block, the state is kept between blocks
+// - Goertzel recalculation from the sample history every N samples (limits rounding drift)
+//   and for blocks of N or more samples
+// - cost per sample scales with the number of bins, not with log N
+
+class FFTWSliding
+{
+public:
+    FFTWSliding();
+
+    // Set length and bins (in units of fsamp/N), clears the state if anything changed
+    void configure(const size_t n, const std::vector<double> &k);
+
+    size_t length() const {return len;}
+    const std::vector<double> &bins() const {return k;}
+
+    // Clear history and spectrum
+    void reset();
+
+    // Feed a block of new samples, write the spectrum at the bins to out
+    void update(const double *x, const size_t n, fftw_complex *out);
+
+private:
+    size_t len;
+    std::vector<double> k;
+
+    // Sample history (ring buffer, pos = oldest sample)
+    std::vector<double> hist;
+    size_t pos, sinceSync;
+
+    // Per bin: state, exp(i w), exp(-i w (N-1)), 2 cos w
+    std::vector<double> sr, si, cr, ci, dr, di, coef;
+
+    // Goertzel over the history
+    void resync();
+};
+
+#endif // FFTWSLIDING_H
@@ -0,0 +1,178 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include <epicsGuard.h>
+
+#include "fftwStats.h"
+#include "fftwTrace.h"
+
+bool
+FFTWStats::parse(const std::string &spec, Phase &phase, Kind &kind)
+{
+    for (int p = 0; p < NPhases; p++) {
+        const std::string name = PhaseName(static_cast<Phase>(p));
+        if (spec.compare(0, name.size(), name))
+            continue;
+        if (spec.size() == name.size()) {
+            phase = static_cast<Phase>(p);
+            kind = Mean;
+            return true;
+        }
+        if (spec[name.size()] != '-')
+            continue;
+        const std::string k = spec.substr(name.size() + 1);
+        for (int i = Last; i <= Hist; i++) {
+            if (k == KindName(static_cast<Kind>(i))) {
+                phase = static_cast<Phase>(p);
+                kind = static_cast<Kind>(i);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+double
+FFTWStats::Summary::get(const Kind k) const
+{
+    switch (k) {
+    case Last:
+        return last;
+    case Min:
+        return min;
+    case Mean:
+        return mean;
+    case Max:
+        return max;
+    case P99:
+        return p99;
+    case CpuMean:
+        return cpumean;
+    case Hist:
+        break;
+    }
+    return 0.0;
+}
+
+FFTWStats::FFTWStats()
+    : owner("")
+{
+    for (auto &d : data) {
+        d.wall.resize(nsamples);
+        d.cpu.resize(nsamples);
+        d.next = 0;
+        d.count = 0;
+        d.hist.resize(nbins);
+    }
+}
+
+void
+FFTWStats::add(const Phase p, const double wall, const double cpu)
+{
+    FFTWTrace::complete(PhaseName(p), owner, wall);
+
+    // histogram bin: log2 of microseconds
+    size_t bin = 0;
+    if (wall >= 2e-6)
+        bin = std::min<size_t>(static_cast<size_t>(std::log2(wall * 1e6)), nbins - 1);
+
+    epicsGuard<epicsMutex> G(lock);
+    PhaseData &d = data[p];
+    d.wall[d.next] = wall;
+    d.cpu[d.next] = cpu;
+    d.next = (d.next + 1) % nsamples;
+    if (d.count < nsamples)
+        d.count++;
+    d.hist[bin]++;
+}
+
+void
+FFTWStats::reset()
+{
+    epicsGuard<epicsMutex> G(lock);
+    for (auto &d : data) {
+        d.next = 0;
+        d.count = 0;
+        std::fill(d.hist.begin(), d.hist.end(), 0.0);
+    }
+}
+
+FFTWStats::Summary
+FFTWStats::summary(const Phase p) const
+{
+    Summary s = {0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    std::vector<double> samples;
+    {
+        epicsGuard<epicsMutex> G(lock);
+        const PhaseData &d = data[p];
+        if (!d.count)
+            return s;
+        s.count = d.count;
+        s.last = d.wall[(d.next + nsamples - 1) % nsamples];
+        samples.assign(d.wall.begin(), d.wall.begin() + d.count);
+        double cpusum = 0.0;
+        for (size_t i = 0; i < d.count; i++)
+            cpusum += d.cpu[i];
+        s.cpumean = cpusum / d.count;
+    }
+
+    double sum = 0.0;
+    s.min = s.max = samples[0];
+    for (auto v : samples) {
+        sum += v;
+        if (v < s.min)
+            s.min = v;
+        if (v > s.max)
+            s.max = v;
+    }
+    s.mean = sum / samples.size();
+
+    size_t k = (samples.size() * 99) / 100;
+    if (k >= samples.size())
+        k = samples.size() - 1;
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    s.p99 = samples[k];
+    return s;
+}
+
+std::vector<double>
+FFTWStats::histogram(const Phase p) const
+{
+    epicsGuard<epicsMutex> G(lock);
+    return data[p].hist;
+}
+
+void
+FFTWStats::show(const unsigned int verbosity, const unsigned char indent) const
+{
+    std::cout << "\n"
+              << std::setw(indent) << "" << std::left << std::setw(11) << "Phase" << std::right << std::setw(8)
+              << "count" << std::setw(12) << "last" << std::setw(12) << "min" << std::setw(12) << "mean"
+              << std::setw(12) << "max" << std::setw(12) << "p99" << std::setw(12) << "cpu";
+    for (int p = 0; p < NPhases; p++) {
+        Summary s = summary(static_cast<Phase>(p));
+        std::cout << "\n"
+                  << std::setw(indent) << "" << std::left << std::setw(11) << PhaseName(static_cast<Phase>(p))
+                  << std::right << std::setw(8) << s.count << std::setw(12) << s.last << std::setw(12) << s.min
+                  << std::setw(12) << s.mean << std::setw(12) << s.max << std::setw(12) << s.p99 << std::setw(12)
+                  << s.cpumean;
+        if (verbosity > 2) {
+            std::vector<double> h = histogram(static_cast<Phase>(p));
+            std::cout << "\n" << std::setw(indent + 2) << "" << "hist:";
+            for (auto n : h)
+                std::cout << " " << n;
+        }
+    }
+}
@@ -0,0 +1,192 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWSTATS_H
+#define FFTWSTATS_H
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <epicsMutex.h>
+#include <errlog.h>
+
+extern int FFTWDebug;
+
+// Windows implementation of clock_gettime
+#ifdef _WIN32
+#define CLOCK_PROCESS_CPUTIME_ID 0
+#define CLOCK_MONOTONIC 1
+#define CLOCK_THREAD_CPUTIME_ID 2
+#    include <Windows.h>
+#    include <minwinbase.h>
+int clock_gettime(int, struct timespec *spec);
+#endif
+
+// Performance timer
+// - wall: monotonic clock
+// - cpu: CPU time of the calling thread
+// start() and snap() must be called on the same thread
+struct PTimer {
+    timespec wstart, cstart;
+    double wall, cpu; // last interval [s]
+    PTimer() : wall(0.0), cpu(0.0) {start();}
+    void start()
+    {
+        clock_gettime(CLOCK_MONOTONIC, &wstart);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cstart);
+    }
+    // Returns the wall clock interval since start or last snap
+    double snap()
+    {
+        timespec wnow, cnow;
+        clock_gettime(CLOCK_MONOTONIC, &wnow);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cnow);
+        wall = wnow.tv_sec-wstart.tv_sec + 1e-9*(wnow.tv_nsec-wstart.tv_nsec);
+        cpu = cnow.tv_sec-cstart.tv_sec + 1e-9*(cnow.tv_nsec-cstart.tv_nsec);
+        wstart = wnow;
+        cstart = cnow;
+        return wall;
+    }
+    // Print msg if elapsed time is greater than the given threshold
+    void maybeSnap(const char *msg, double threshold=0.0)
+    {
+        double interval = snap();
+        if(FFTWDebug && interval>threshold) {
+            errlogPrintf("%s over threshold %f > %f\n", msg, interval, threshold);
+        }
+    }
+};
+
+// FFTWStats
+// - per-phase timing of the calculations of one instance
+// - rolling min/mean/max/p99 over the last samples, histogram since start
+
+class FFTWStats
+{
+public:
+    enum Phase {
+        QueueWait = 0,
+        Prepare,
+        Window,
+        Plan,
+        Execute,
+        PostProc,
+        Publish,
+        Total,
+        NPhases
+    };
+
+    static inline const char *
+    PhaseName(const Phase p)
+    {
+        switch (p) {
+        case QueueWait:
+            return "queue-wait";
+        case Prepare:
+            return "prepare";
+        case Window:
+            return "window";
+        case Plan:
+            return "plan";
+        case Execute:
+            return "exec";
+        case PostProc:
+            return "postproc";
+        case Publish:
+            return "publish";
+        case Total:
+            return "total";
+        case NPhases:
+            break;
+        }
+        return "?";
+    }
+
+    enum Kind {
+        Last = 0,
+        Min,
+        Mean,
+        Max,
+        P99,
+        CpuMean,
+        Hist
+    };
+
+    static inline const char *
+    KindName(const Kind k)
+    {
+        switch (k) {
+        case Last:
+            return "last";
+        case Min:
+            return "min";
+        case Mean:
+            return "mean";
+        case Max:
+            return "max";
+        case P99:
+            return "p99";
+        case CpuMean:
+            return "cpu";
+        case Hist:
+            return "hist";
+        }
+        return "?";
+    }
+
+    // Parse "<phase>[-<kind>]" (e.g. "exec-p99", "queue-wait"), false if unknown
+    static bool parse(const std::string &spec, Phase &phase, Kind &kind);
+
+    // Samples in the rolling window
+    static const size_t nsamples = 1000;
+    // Histogram bins: bin 0 < 2us, bin k covers [2^k, 2^(k+1)) us, last bin open
+    static const size_t nbins = 24;
+
+    struct Summary
+    {
+        size_t count;
+        double last, min, mean, max, p99, cpumean;
+        double get(const Kind k) const;
+    };
+
+    FFTWStats();
+
+    // Name used for trace events
+    const char *owner;
+
+    // Add a sample (wall clock and thread CPU time)
+    void add(const Phase p, const double wall, const double cpu = 0.0);
+    void add(const Phase p, const PTimer &t) {add(p, t.wall, t.cpu);}
+
+    // Clear all samples and histograms
+    void reset();
+
+    // Statistics over the rolling window
+    Summary summary(const Phase p) const;
+
+    // Histogram since start [counts per bin]
+    std::vector<double> histogram(const Phase p) const;
+
+    // Print table of all phases
+    void show(const unsigned int verbosity, const unsigned char indent = 0) const;
+
+private:
+    struct PhaseData
+    {
+        std::vector<double> wall, cpu; // ring buffers
+        size_t next, count;
+        std::vector<double> hist;
+    };
+    mutable epicsMutex lock;
+    PhaseData data[NPhases];
+};
+
+#endif // FFTWSTATS_H
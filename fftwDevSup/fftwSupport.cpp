@@ -12,6 +12,7 @@
  *  based on pscdrv/sigApp by Michael Davidsaver <mdavidsaver@ospreydcs.com>
  */
 
+#include <cmath>
 #include <string>
 #include <cstring>
 #include <set>
@@ -43,7 +44,10 @@
 
 #include "fftwVersion.h"
 #include "fftwConnector.h"
+#include "fftwGroup.h"
 #include "fftwInstance.h"
+#include "fftwNuma.h"
+#include "fftwZoom.h"
 
 namespace {
 
@@ -159,10 +163,16 @@ signalTypeIndex(const std::string &name)
         return FFTWConnector::InputReal;
     else if (name == "input-imag")
         return FFTWConnector::InputReal;
+    else if (name == "input-tach")
+        return FFTWConnector::InputTach;
     else if (name == "windowtype")
         return FFTWConnector::SetWindowType;
     else if (name == "sample-freq")
         return FFTWConnector::SetSampleFreq;
+    else if (name == "image-rows")
+        return FFTWConnector::SetImageRows;
+    else if (name == "image-cols")
+        return FFTWConnector::SetImageCols;
     else if (name == "exectime")
         return FFTWConnector::ExecutionTime;
     else if (name == "output-real")
@@ -177,6 +187,26 @@ signalTypeIndex(const std::string &name)
         return FFTWConnector::OutputFscale;
     else if (name == "output-window")
         return FFTWConnector::OutputWindow;
+    else if (name == "output-corr")
+        return FFTWConnector::OutputCorr;
+    else if (name == "corr-delay")
+        return FFTWConnector::CorrDelay;
+    else if (name.compare(0, 8, "profile-") == 0)
+        return FFTWConnector::OutputProfile;
+    else if (name == "output-coef")
+        return FFTWConnector::OutputCoef;
+    else if (name == "output-inverse")
+        return FFTWConnector::OutputInverse;
+    else if (name == "output-envelope" || name == "output-iphase" || name == "output-ifreq")
+        return FFTWConnector::OutputAnalytic;
+    else if (name.compare(0, 7, "output-") == 0)
+        return FFTWConnector::OutputCross;
+    else if (name.compare(0, 5, "stat-") == 0)
+        return FFTWConnector::Statistic;
+    else if (name.compare(0, 5, "peak-") == 0)
+        return FFTWConnector::OutputPeak;
+    else if (name.compare(0, 5, "harm-") == 0)
+        return FFTWConnector::Harmonics;
     else
         return FFTWConnector::None;
 }
@@ -244,8 +274,11 @@ parseLink(dbCommon *prec, const char *config)
                 conn->sigtype = sig;
                 switch (sig) {
                 case FFTWConnector::InputReal:
+                case FFTWConnector::InputTach:
                 case FFTWConnector::SetWindowType:
                 case FFTWConnector::SetSampleFreq:
+                case FFTWConnector::SetImageRows:
+                case FFTWConnector::SetImageCols:
                     conn->inst->inputs.push_back(conn.get());
                     break;
                 case FFTWConnector::OutputReal:
@@ -275,6 +308,54 @@ parseLink(dbCommon *prec, const char *config)
                 case FFTWConnector::ExecutionTime:
                     conn->inst->outputs.push_back(conn.get());
                     break;
+                case FFTWConnector::Statistic:
+                case FFTWConnector::StatisticHist:
+                    if (!FFTWStats::parse(token.substr(5), conn->statPhase, conn->statKind))
+                        throw std::runtime_error(SB() << "unknown statistic '" << token << "'");
+                    if (conn->statKind == FFTWStats::Hist)
+                        conn->sigtype = FFTWConnector::StatisticHist;
+                    conn->inst->outputs.push_back(conn.get());
+                    break;
+                case FFTWConnector::OutputPeak:
+                    if (!FFTWPeaks::parse(token.substr(5), conn->peakQuantity))
+                        throw std::runtime_error(SB() << "unknown peak quantity '" << token << "'");
+                    conn->inst->outputs.push_back(conn.get());
+                    conn->inst->usePeaks = true;
+                    break;
+                case FFTWConnector::Harmonics:
+                    if (!FFTWPeaks::parse(token.substr(5), conn->harmFigure))
+                        throw std::runtime_error(SB() << "unknown harmonic figure '" << token << "'");
+                    conn->inst->outputs.push_back(conn.get());
+                    conn->inst->useHarmonics = true;
+                    break;
+                case FFTWConnector::OutputCross:
+                    if (!FFTWCross::parse(token.substr(7), conn->crossQuantity))
+                        throw std::runtime_error(SB() << "unknown output '" << token << "'");
+                    conn->inst->outputs.push_back(conn.get());
+                    break;
+                case FFTWConnector::OutputProfile:
+                    if (!FFTWProfile::parse(token.substr(8), conn->profileKind))
+                        throw std::runtime_error(SB() << "unknown profile '" << token << "'");
+                    conn->inst->outputs.push_back(conn.get());
+                    conn->inst->useProfile[conn->profileKind] = true;
+                    break;
+                case FFTWConnector::OutputCoef:
+                    conn->inst->outputs.push_back(conn.get());
+                    conn->inst->useCoef = true;
+                    break;
+                case FFTWConnector::OutputInverse:
+                    conn->inst->outputs.push_back(conn.get());
+                    conn->inst->useInverse = true;
+                    conn->inst->fftw.set_r2r_inverse(true, conn->inst->fftw.r2r_keep);
+                    break;
+                case FFTWConnector::OutputAnalytic:
+                    FFTWHilbert::parse(token.substr(7), conn->analyticQuantity);
+                    conn->inst->outputs.push_back(conn.get());
+                    break;
+                case FFTWConnector::OutputCorr:
+                case FFTWConnector::CorrDelay:
+                    conn->inst->outputs.push_back(conn.get());
+                    break;
                 case FFTWConnector::None:
                     break;
                 }
@@ -305,8 +386,223 @@ parseLink(dbCommon *prec, const char *config)
                 off = 0ul;
             }
             conn->setOffset(off);
+        } else if (options[0] == "priority") {
+            if (options[1] == "high" || options[1] == "0")
+                conn->inst->priority = FFTWScheduler::High;
+            else if (options[1] == "normal" || options[1] == "1")
+                conn->inst->priority = FFTWScheduler::Normal;
+            else if (options[1] == "low" || options[1] == "2")
+                conn->inst->priority = FFTWScheduler::Low;
+            else
+                throw std::runtime_error(SB() << "illegal priority '" << options[1] << "'");
+        } else if (options[0] == "deadline") {
+            double budget = 0.0;
+            try {
+                budget = std::stod(options[1]);
+            } catch (std::exception &e) {
+                budget = NAN;
+            }
+            if (!(budget >= 0.0) || std::isinf(budget))
+                throw std::runtime_error(SB() << "illegal deadline '" << options[1] << "'");
+            conn->inst->deadline = budget;
+        } else if (options[0] == "skipLate") {
+            conn->inst->skipLate = isYes(options[1][0]);
+        } else if (options[0] == "group") {
+            if (conn->inst->group && conn->inst->group->name != options[1])
+                throw std::runtime_error(SB() << "instance '" << conn->inst->name << "' already in group '"
+                                              << conn->inst->group->name << "'");
+            FFTWGroup::findOrCreate(options[1])->add(conn->inst);
+        } else if (options[0] == "numa") {
+            int node = -1;
+            if (options[1] == "auto") {
+                if (conn->inst->numaNode < 0 && FFTWNuma::nodes() > 1)
+                    node = FFTWNuma::autoNode();
+            } else {
+                try {
+                    node = std::stoi(options[1]);
+                } catch (std::exception &e) {
+                    throw std::runtime_error(SB() << "illegal NUMA node '" << options[1] << "'");
+                }
+            }
+            if (node >= 0 && node != conn->inst->numaNode && !conn->inst->setNumaNode(node))
+                throw std::runtime_error(SB() << "can't bind instance '" << conn->inst->name << "' to NUMA node "
+                                              << node);
+        } else if (options[0] == "inplace") {
+            conn->inst->fftw.set_inplace(isYes(options[1][0]));
+        } else if (options[0] == "smallkernels") {
+            conn->inst->fftw.set_small_kernels(isYes(options[1][0]));
+        } else if (options[0] == "transform") {
+            fftw_r2r_kind kind;
+            if (options[1] == "r2c")
+                conn->inst->fftw.set_transform(FFTWCalc::R2c_1d);
+            else if (options[1] == "sdft")
+                conn->inst->fftw.set_transform(FFTWCalc::SlidingDFT);
+            else if (options[1] == "zoom")
+                conn->inst->fftw.set_transform(FFTWCalc::Zoom);
+            else if (options[1] == "order")
+                conn->inst->fftw.set_transform(FFTWCalc::Order);
+            else if (options[1] == "r2c2d")
+                conn->inst->fftw.set_transform(FFTWCalc::R2c_2d);
+            else if (FFTWCalc::parseR2rKind(options[1], kind))
+                conn->inst->fftw.set_r2r(kind);
+            else
+                throw std::runtime_error(SB() << "illegal transform type '" << options[1] << "'");
+        } else if (options[0] == "bins" || options[0] == "freqs") {
+            std::vector<double> values;
+            for (const auto &v : splitString(options[1], ',')) {
+                try {
+                    values.push_back(std::stod(v));
+                } catch (std::exception &e) {
+                    throw std::runtime_error(SB() << "illegal " << options[0] << " value '" << v << "'");
+                }
+            }
+            conn->inst->fftw.set_tracking(values, options[0] == "freqs");
+        } else if (options[0] == "length") {
+            unsigned long len = 0;
+            try {
+                len = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                throw std::runtime_error(SB() << "illegal length '" << options[1] << "'");
+            }
+            conn->inst->fftw.set_tracking(conn->inst->fftw.track, conn->inst->fftw.track_freq, len);
+        } else if (options[0] == "center" || options[0] == "span") {
+            FFTWCalc &calc = conn->inst->fftw;
+            double value = 0.0;
+            try {
+                value = std::stod(options[1]);
+            } catch (std::exception &e) {
+                value = NAN;
+            }
+            if (!std::isfinite(value) || (options[0] == "span" && value <= 0.0))
+                throw std::runtime_error(SB() << "illegal " << options[0] << " '" << options[1] << "'");
+            if (options[0] == "center")
+                calc.set_zoom(value, calc.zoom_span, calc.zoom_bins);
+            else
+                calc.set_zoom(calc.zoom_center, value, calc.zoom_bins);
+        } else if (options[0] == "nbins") {
+            FFTWCalc &calc = conn->inst->fftw;
+            unsigned long n = 0;
+            try {
+                // (stoul accepts and wraps negative numbers)
+                if (options[1].find('-') == std::string::npos)
+                    n = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                n = 0;
+            }
+            if (!n || n > FFTWZoom::maxBins)
+                throw std::runtime_error(SB() << "illegal nbins '" << options[1] << "'");
+            calc.set_zoom(calc.zoom_center, calc.zoom_span, n);
+        } else if (options[0] == "spr" || options[0] == "ppr") {
+            FFTWOrder &order = conn->inst->fftw.order;
+            unsigned long n = 0;
+            try {
+                n = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                n = 0;
+            }
+            if (!n)
+                throw std::runtime_error(SB() << "illegal " << options[0] << " '" << options[1] << "'");
+            if (options[0] == "spr")
+                conn->inst->fftw.set_order(n, order.pulsesPerRev(), order.threshold());
+            else
+                conn->inst->fftw.set_order(order.samplesPerRev(), n, order.threshold());
+        } else if (options[0] == "tachlevel") {
+            FFTWOrder &order = conn->inst->fftw.order;
+            double level = 0.0;
+            try {
+                level = std::stod(options[1]);
+            } catch (std::exception &e) {
+                throw std::runtime_error(SB() << "illegal tach level '" << options[1] << "'");
+            }
+            conn->inst->fftw.set_order(order.samplesPerRev(), order.pulsesPerRev(), level);
+        } else if (options[0] == "rows" || options[0] == "cols" || options[0] == "threads") {
+            FFTWCalc &calc = conn->inst->fftw;
+            unsigned long n = 0;
+            try {
+                n = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                n = 0;
+            }
+            if (!n)
+                throw std::runtime_error(SB() << "illegal " << options[0] << " '" << options[1] << "'");
+            if (options[0] == "rows")
+                calc.set_image(n, calc.img_cols);
+            else if (options[0] == "cols")
+                calc.set_image(calc.img_rows, n);
+            else
+                calc.set_image_threads(static_cast<int>(n));
+        } else if (options[0] == "keep") {
+            unsigned long n = 0;
+            try {
+                n = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                throw std::runtime_error(SB() << "illegal number of coefficients '" << options[1] << "'");
+            }
+            conn->inst->fftw.set_r2r_inverse(conn->inst->fftw.r2r_inverse, n);
+        } else if (options[0] == "decimate") {
+            unsigned long factor = 0;
+            try {
+                factor = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                throw std::runtime_error(SB() << "illegal decimation factor '" << options[1] << "'");
+            }
+            conn->inst->fftw.set_decimation(factor, conn->inst->fftw.mixfreq);
+        } else if (options[0] == "mix") {
+            double f = 0.0;
+            try {
+                f = std::stod(options[1]);
+            } catch (std::exception &e) {
+                throw std::runtime_error(SB() << "illegal mixer frequency '" << options[1] << "'");
+            }
+            conn->inst->fftw.set_decimation(conn->inst->fftw.decimation, f);
+        } else if (options[0] == "peaks" || options[0] == "harmonics") {
+            unsigned long n = 0;
+            try {
+                n = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                n = 0;
+            }
+            if (!n)
+                throw std::runtime_error(SB() << "illegal number of " << options[0] << " '" << options[1] << "'");
+            if (options[0] == "peaks")
+                conn->inst->peaks.npeaks = n;
+            else
+                conn->inst->peaks.nharm = n;
+        } else if (options[0] == "interp") {
+            if (options[1] == "parabolic")
+                conn->inst->peaks.interp = FFTWPeaks::Parabolic;
+            else if (options[1] == "gaussian")
+                conn->inst->peaks.interp = FFTWPeaks::Gaussian;
+            else
+                throw std::runtime_error(SB() << "illegal interpolation '" << options[1] << "'");
+        } else if (options[0] == "reduce") {
+            conn->reduce.reset(FFTWReduce::create(options[1]));
+            if (!conn->reduce)
+                throw std::runtime_error(SB() << "illegal reduction '" << options[1] << "'");
+        } else if (options[0] == "average") {
+            unsigned long n = 0;
+            try {
+                n = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                n = 0;
+            }
+            if (!n)
+                throw std::runtime_error(SB() << "illegal number of averages '" << options[1] << "'");
+            conn->inst->crossAverage = n;
+        } else if (options[0] == "ch") {
+            unsigned long ch = 0;
+            try {
+                ch = std::stoul(options[1]);
+            } catch (std::exception &e) {
+                throw std::runtime_error(SB() << "illegal channel '" << options[1] << "'");
+            }
+            conn->setChannel(ch);
         }
     }
+    // two-input signals: the response defaults to channel 1 (channel 0 is the reference)
+    if (conn->sigtype == FFTWConnector::OutputCross && conn->getChannel() == 0)
+        conn->setChannel(1);
+    conn->inst->useChannels(conn.get());
     return conn.release();
 }
 
@@ -407,6 +703,9 @@ init_record_write_arr(REC *prec)
     return status;
 }
 
+// aSub inputs INPA..INPU
+const size_t ASUB_NINPUTS = 21;
+
 long
 init_double_array_asub(aSubRecord *prec)
 {
@@ -414,7 +713,18 @@ init_double_array_asub(aSubRecord *prec)
         dbCommon *pdbc = reinterpret_cast<dbCommon *>(prec);
         const char *s = DBEntry(pdbc).info("fftw:CONFIG", "");
         if (s[0] != '\0') {
-            prec->dpvt = parseLink(pdbc, s);
+            FFTWConnector *conn = parseLink(pdbc, s);
+            prec->dpvt = conn;
+            // channels: consecutive array inputs (type DOUBLE, NOx > 1) starting at INPA
+            if (conn->sigtype == FFTWConnector::InputReal) {
+                const epicsUInt32 *no = &prec->noa;
+                const epicsEnum16 *ft = &prec->fta;
+                size_t count = 1;
+                while (count < ASUB_NINPUTS && ft[count] == menuFtypeDOUBLE && no[count] > 1)
+                    count++;
+                conn->setChannel(conn->getChannel(), count);
+                conn->inst->useChannels(conn);
+            }
         }
     }
     CATCH(__FUNCTION__)
@@ -492,6 +802,17 @@ write_double(REC *prec)
             if (prec->tpro > 1)
                 std::cerr << prec->name << ": set sample freq " << conn->getSampleFreq() << std::endl;
         }
+        if (conn->sigtype == FFTWConnector::SetImageRows || conn->sigtype == FFTWConnector::SetImageCols) {
+            const double val = analogEGU2Raw<double>(prec, prec->val);
+            failed = !(val >= 0.0);
+            if (!failed) {
+                conn->setDimension(static_cast<size_t>(val));
+                if (prec->tpro > 1)
+                    std::cerr << prec->name << ": set image "
+                              << (conn->sigtype == FFTWConnector::SetImageRows ? "rows " : "cols ")
+                              << conn->getDimension() << std::endl;
+            }
+        }
         if (!failed && conn->inst->triggerSrc == conn) {
             conn->setTimestamp(prec->time);
             conn->trigger();
@@ -512,9 +833,10 @@ write_double_arr(REC *prec)
     TRY
     {
         bool failed = true;
-        if (conn->sigtype == FFTWConnector::InputReal) {
+        if (conn->sigtype == FFTWConnector::InputReal || conn->sigtype == FFTWConnector::InputTach) {
             if (prec->tpro > 1)
-                std::cerr << prec->name << ": set input (real)" << std::endl;
+                std::cerr << prec->name << ": set input (" << (conn->sigtype == FFTWConnector::InputTach ? "tach" : "real")
+                          << ")" << std::endl;
             conn->setNextInputValue(prec->bptr, prec->nord);
             failed = false;
         }
@@ -538,9 +860,14 @@ write_double_array_asub(aSubRecord *prec)
     {
         bool failed = true;
         if (conn->sigtype == FFTWConnector::InputReal) {
-            if (prec->tpro > 1)
-                std::cerr << prec->name << ": set input (real) [" << prec->nea << "]" << std::endl;
-            conn->setNextInputValue(prec->a, prec->nea);
+            void **val = &prec->a;
+            const epicsUInt32 *ne = &prec->nea;
+            for (size_t i = 0; i < conn->getChannelCount(); i++) {
+                if (prec->tpro > 1)
+                    std::cerr << prec->name << ": set input (real) ch " << conn->getChannel() + i << " [" << ne[i]
+                              << "]" << std::endl;
+                conn->setNextInputValue(val[i], ne[i], i);
+            }
             failed = false;
         }
         if (!failed && conn->inst->triggerSrc == conn) {
@@ -565,7 +892,8 @@ read_double(REC *prec)
         long status = 0;
         bool failed = true;
 
-        if (conn->sigtype == FFTWConnector::ExecutionTime) {
+        if (conn->sigtype == FFTWConnector::ExecutionTime || conn->sigtype == FFTWConnector::Statistic
+            || conn->sigtype == FFTWConnector::Harmonics || conn->sigtype == FFTWConnector::CorrDelay) {
             double val = analogRaw2EGU<double>(prec, conn->getRuntime());
             prec->val = val;
             prec->udf = 0;
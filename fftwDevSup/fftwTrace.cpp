@@ -0,0 +1,159 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+
+#include "fftwScheduler.h"
+#include "fftwTrace.h"
+
+int FFTWTrace::enabled;
+
+namespace {
+
+struct Event
+{
+    double ts, dur; // [s]
+    const char *what;
+    const char *inst;
+    char ph;
+};
+
+struct Buffer
+{
+    epicsMutex lock;
+    std::string thread;
+    unsigned int tid;
+    std::vector<Event> ring;
+    size_t next, count;
+};
+
+epicsThreadOnceId onceId = EPICS_THREAD_ONCE_INIT;
+epicsThreadPrivateId bufferKey;
+epicsMutex *buffersLock;
+std::vector<Buffer *> *buffers;
+
+void
+traceInit(void *)
+{
+    bufferKey = epicsThreadPrivateCreate();
+    buffersLock = new epicsMutex;
+    buffers = new std::vector<Buffer *>;
+}
+
+// Buffer of the calling thread, created on first use
+Buffer *
+threadBuffer()
+{
+    epicsThreadOnce(&onceId, traceInit, nullptr);
+    auto buf = static_cast<Buffer *>(epicsThreadPrivateGet(bufferKey));
+    if (!buf) {
+        buf = new Buffer;
+        const char *name = epicsThreadGetNameSelf();
+        buf->thread = name ? name : "?";
+        buf->ring.resize(FFTWTrace::nevents);
+        buf->next = buf->count = 0;
+        epicsGuard<epicsMutex> G(*buffersLock);
+        buf->tid = static_cast<unsigned int>(buffers->size() + 1);
+        buffers->push_back(buf);
+        epicsThreadPrivateSet(bufferKey, buf);
+    }
+    return buf;
+}
+
+// JSON string escape (instance and thread names)
+std::string
+quote(const char *s)
+{
+    std::string q("\"");
+    for (; s && *s; s++) {
+        if (*s == '"' || *s == '\\')
+            q += '\\';
+        if (static_cast<unsigned char>(*s) >= 0x20)
+            q += *s;
+    }
+    return q + '"';
+}
+
+} // namespace
+
+void
+FFTWTrace::record(const char *what, const char *inst, char ph, double dur)
+{
+    Buffer *buf = threadBuffer();
+    const double now = FFTWScheduler::now();
+
+    epicsGuard<epicsMutex> G(buf->lock);
+    Event &e = buf->ring[buf->next];
+    e.ts = now - dur;
+    e.dur = dur;
+    e.what = what;
+    e.inst = inst;
+    e.ph = ph;
+    buf->next = (buf->next + 1) % nevents;
+    if (buf->count < nevents)
+        buf->count++;
+}
+
+void
+FFTWTrace::enable(bool on)
+{
+    epicsThreadOnce(&onceId, traceInit, nullptr);
+    if (on) {
+        epicsGuard<epicsMutex> G(*buffersLock);
+        for (auto buf : *buffers) {
+            epicsGuard<epicsMutex> BG(buf->lock);
+            buf->next = buf->count = 0;
+        }
+    }
+    enabled = on;
+}
+
+long
+FFTWTrace::dump(const char *filename)
+{
+    epicsThreadOnce(&onceId, traceInit, nullptr);
+
+    std::ofstream out(filename);
+    if (!out)
+        return -1;
+
+    long n = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out.precision(3);
+    out << std::fixed;
+
+    epicsGuard<epicsMutex> G(*buffersLock);
+    for (auto buf : *buffers) {
+        epicsGuard<epicsMutex> BG(buf->lock);
+        out << (n++ ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid
+            << ",\"args\":{\"name\":" << quote(buf->thread.c_str()) << "}}";
+        const size_t first = (buf->next + nevents - buf->count) % nevents;
+        for (size_t i = 0; i < buf->count; i++) {
+            const Event &e = buf->ring[(first + i) % nevents];
+            out << ",\n{\"name\":" << quote(e.what) << ",\"cat\":\"fftw\",\"ph\":\"" << e.ph
+                << "\",\"pid\":1,\"tid\":" << buf->tid << ",\"ts\":" << e.ts * 1e6;
+            if (e.ph == 'X')
+                out << ",\"dur\":" << e.dur * 1e6;
+            else
+                out << ",\"s\":\"t\"";
+            out << ",\"args\":{\"instance\":" << quote(e.inst) << "}}";
+            n++;
+        }
+    }
+    out << "\n]}\n";
+
+    return out ? n : -1;
+}
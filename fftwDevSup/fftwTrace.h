@@ -0,0 +1,56 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWTRACE_H
+#define FFTWTRACE_H
+
+#include <cstddef>
+
+// FFTWTrace
+// - optional timeline tracing of triggers, jobs and calculation phases
+// - events are kept in per-thread ring buffers
+// - dumped as Chrome trace / Perfetto JSON
+
+class FFTWTrace
+{
+public:
+    // Tracing switch: checked before anything else, no cost when off
+    static int enabled;
+
+    // Events per thread buffer
+    static const size_t nevents = 16384;
+
+    // Instant event (e.g. trigger)
+    static inline void
+    instant(const char *what, const char *inst)
+    {
+        if (enabled)
+            record(what, inst, 'i', 0.0);
+    }
+
+    // Complete event that ended now and lasted dur [s]
+    static inline void
+    complete(const char *what, const char *inst, double dur)
+    {
+        if (enabled)
+            record(what, inst, 'X', dur);
+    }
+
+    // Switch tracing on (clearing all buffers) or off
+    static void enable(bool on);
+
+    // Write all buffered events to a file, returns number of events (-1 on error)
+    static long dump(const char *filename);
+
+private:
+    static void record(const char *what, const char *inst, char ph, double dur);
+};
+
+#endif // FFTWTRACE_H
@@ -0,0 +1,129 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "fftwZoom.h"
+
+namespace {
+
+const long double PI = 3.14159265358979323846264338327950288L;
+
+// exp(i a pi x^2), the phase reduced in extended precision (x^2 gets large)
+void
+chirpAt(const double a, const size_t x, fftw_complex &c)
+{
+    const long double xl = static_cast<long double>(x);
+    const long double turns = fmodl(0.5L * a * xl * xl, 1.0L);
+    const double phi = static_cast<double>(2.0L * PI * turns);
+    c[0] = cos(phi);
+    c[1] = sin(phi);
+}
+
+} // namespace
+
+FFTWZoom::FFTWZoom()
+    : n(0)
+    , m(0)
+    , len(0)
+    , f0(0.0)
+    , df(0.0)
+{}
+
+void
+FFTWZoom::set_memory(FFTWMemory *mem)
+{
+    typedef FFTWAllocator<fftw_complex> alloc_c;
+    fwd.clear();
+    bwd.clear();
+    chirp = cvector(alloc_c(mem));
+    post = cvector(alloc_c(mem));
+    kernel = cvector(alloc_c(mem));
+    buf = cvector(alloc_c(mem));
+    n = m = len = 0;
+}
+
+void
+FFTWZoom::configure(const size_t nsamp, const double start, const double step, const size_t nbins)
+{
+    if (nsamp == n && nbins == m && start == f0 && step == df && len)
+        return;
+    n = nsamp;
+    m = nbins;
+    f0 = start;
+    df = step;
+
+    size_t l = 1;
+    while (l < n + m - 1)
+        l <<= 1;
+    if (l != len) {
+        len = l;
+        fwd.clear();
+        bwd.clear();
+        buf.resize(len);
+        kernel.resize(len);
+        // (planning overwrites buf)
+        fwd = FFTWCalc::plan_dft(len, buf.data(), FFTW_FORWARD);
+        bwd = FFTWCalc::plan_dft(len, buf.data(), FFTW_BACKWARD);
+    }
+
+    // A^-n W^(n^2/2) = exp(-i 2 pi f0 n) exp(-i pi df n^2)
+    chirp.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        fftw_complex w;
+        chirpAt(-df, i, w);
+        const double phi = -2.0 * static_cast<double>(PI) * fmod(f0 * i, 1.0);
+        const double ar = cos(phi), ai = sin(phi);
+        chirp[i][0] = ar * w[0] - ai * w[1];
+        chirp[i][1] = ar * w[1] + ai * w[0];
+    }
+    post.resize(m);
+    for (size_t k = 0; k < m; k++)
+        chirpAt(-df, k, post[k]);
+
+    // kernel W^(-j^2/2) for j = -(n-1) .. m-1, circular, transformed and scaled for the backward FFT
+    for (size_t i = 0; i < len; i++)
+        buf[i][0] = buf[i][1] = 0.0;
+    for (size_t j = 0; j < m; j++)
+        chirpAt(df, j, buf[j]);
+    for (size_t j = 1; j < n; j++)
+        chirpAt(df, j, buf[len - j]);
+    fftw_execute(fwd.get());
+    for (size_t i = 0; i < len; i++) {
+        kernel[i][0] = buf[i][0] / len;
+        kernel[i][1] = buf[i][1] / len;
+    }
+}
+
+void
+FFTWZoom::transform(const double *x, fftw_complex *out)
+{
+    for (size_t i = 0; i < n; i++) {
+        buf[i][0] = x[i] * chirp[i][0];
+        buf[i][1] = x[i] * chirp[i][1];
+    }
+    for (size_t i = n; i < len; i++)
+        buf[i][0] = buf[i][1] = 0.0;
+
+    fftw_execute(fwd.get());
+    for (size_t i = 0; i < len; i++) {
+        const double re = buf[i][0] * kernel[i][0] - buf[i][1] * kernel[i][1];
+        const double im = buf[i][0] * kernel[i][1] + buf[i][1] * kernel[i][0];
+        buf[i][0] = re;
+        buf[i][1] = im;
+    }
+    fftw_execute(bwd.get());
+
+    for (size_t k = 0; k < m; k++) {
+        out[k][0] = buf[k][0] * post[k][0] - buf[k][1] * post[k][1];
+        out[k][1] = buf[k][0] * post[k][1] + buf[k][1] * post[k][0];
+    }
+}
@@ -0,0 +1,57 @@
+/*************************************************************************\
+* Copyright (c) 2021 ITER Organization.
+* This module is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Author: Ralph Lange <ralph.lange@gmx.de>
+ */
+
+#ifndef FFTWZOOM_H
+#define FFTWZOOM_H
+
+#include <cstddef>
+#include <vector>
+
+#include <fftw3.h>
+
+#include "fftwCalc.h"
+
+// FFTWZoom
+// - chirp-z transform (Bluestein): spectrum of n samples at m bins f0 + k df (normalized to fsamp)
+// - convolution through cached complex FFTW plans of the next power of two >= n + m - 1
+// - chirps and the transformed kernel are recalculated when the band changes
+
+class FFTWZoom
+{
+public:
+    // Largest number of bins accepted from the link options
+    static const size_t maxBins = 1 << 20;
+
+    FFTWZoom();
+
+    // Account all buffers to an instance
+    void set_memory(FFTWMemory *m);
+
+    // Set input size and band, replans if the convolution size changes
+    void configure(const size_t n, const double f0, const double df, const size_t m);
+
+    // Spectrum of x (n samples) at the m bins
+    void transform(const double *x, fftw_complex *out);
+
+    size_t convolutionSize() const {return len;}
+
+private:
+    typedef std::vector<fftw_complex, FFTWAllocator<fftw_complex>> cvector;
+
+    size_t n, m, len;
+    double f0, df;
+
+    // Input chirp A^-n W^(n^2/2), output chirp W^(k^2/2), transformed kernel W^(-j^2/2) / len
+    cvector chirp, post, kernel;
+    cvector buf;
+    Plan fwd, bwd;
+};
+
+#endif // FFTWZOOM_H
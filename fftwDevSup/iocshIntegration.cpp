@@ -16,6 +16,9 @@
 #include <iocsh.h>
 
 #include "fftwInstance.h"
+#include "fftwLoad.h"
+#include "fftwPerf.h"
+#include "fftwTrace.h"
 
 #include <epicsExport.h> // defines epicsExportSharedSymbols
 
@@ -62,10 +65,130 @@ fftwShowCallFunc(const iocshArgBuf *args)
         instance->show(verb);
 }
 
+static const iocshArg fftwReportArg0 = {"format (0 = table, 1 = with phases, 2 = JSON) [0]", iocshArgInt};
+
+static const iocshArg *const fftwReportArg[1] = {&fftwReportArg0};
+
+static const iocshFuncDef fftwReportFuncDef = {"fftwReport", 1, fftwReportArg};
+
+static void
+fftwReportCallFunc(const iocshArgBuf *args)
+{
+    if (args[0].ival < 0) {
+        errlogPrintf("invalid argument #1 (format) '%d'\n", args[0].ival);
+        return;
+    }
+    FFTWInstance::report(args[0].ival);
+}
+
+static const iocshArg fftwTraceArg0 = {"on (1) / off (0)", iocshArgInt};
+
+static const iocshArg *const fftwTraceArg[1] = {&fftwTraceArg0};
+
+static const iocshFuncDef fftwTraceFuncDef = {"fftwTrace", 1, fftwTraceArg};
+
+static void
+fftwTraceCallFunc(const iocshArgBuf *args)
+{
+    FFTWTrace::enable(args[0].ival != 0);
+    errlogPrintf("FFTW tracing %s\n", args[0].ival ? "on (buffers cleared)" : "off");
+}
+
+static const iocshArg fftwTraceDumpArg0 = {"file name", iocshArgString};
+
+static const iocshArg *const fftwTraceDumpArg[1] = {&fftwTraceDumpArg0};
+
+static const iocshFuncDef fftwTraceDumpFuncDef = {"fftwTraceDump", 1, fftwTraceDumpArg};
+
+static void
+fftwTraceDumpCallFunc(const iocshArgBuf *args)
+{
+    if (args[0].sval == nullptr) {
+        errlogPrintf("missing argument #1 (file name)\n");
+        return;
+    }
+
+    long n = FFTWTrace::dump(args[0].sval);
+    if (n < 0)
+        errlogPrintf("can't write '%s'\n", args[0].sval);
+    else
+        errlogPrintf("%ld trace events written to '%s'\n", n, args[0].sval);
+}
+
+static const iocshArg fftwPerfArg0 = {"on (1) / off (0)", iocshArgInt};
+
+static const iocshArg *const fftwPerfArg[1] = {&fftwPerfArg0};
+
+static const iocshFuncDef fftwPerfFuncDef = {"fftwPerf", 1, fftwPerfArg};
+
+static void
+fftwPerfCallFunc(const iocshArgBuf *args)
+{
+    if (FFTWPerf::enable(args[0].ival != 0))
+        errlogPrintf("FFTW hardware counters %s\n", args[0].ival ? "on" : "off");
+    else
+        errlogPrintf("FFTW hardware counters not available\n");
+}
+
+static const iocshArg fftwLoadArg0 = {"instance name (* = all)", iocshArgString};
+static const iocshArg fftwLoadArg1 = {"signal (sine|noise|chirp)", iocshArgString};
+static const iocshArg fftwLoadArg2 = {"number of points [1024]", iocshArgInt};
+static const iocshArg fftwLoadArg3 = {"rate per instance [10 Hz]", iocshArgDouble};
+static const iocshArg fftwLoadArg4 = {"max rate (ramp up) [rate]", iocshArgDouble};
+static const iocshArg fftwLoadArg5 = {"step duration [5 s]", iocshArgDouble};
+
+static const iocshArg *const fftwLoadArg[6]
+    = {&fftwLoadArg0, &fftwLoadArg1, &fftwLoadArg2, &fftwLoadArg3, &fftwLoadArg4, &fftwLoadArg5};
+
+static const iocshFuncDef fftwLoadFuncDef = {"fftwLoad", 6, fftwLoadArg};
+
+static void
+fftwLoadCallFunc(const iocshArgBuf *args)
+{
+    FFTWLoad::Signal signal = FFTWLoad::Sines;
+    int npoints = args[2].ival > 0 ? args[2].ival : 1024;
+    double rate = args[3].dval > 0.0 ? args[3].dval : 10.0;
+    double maxrate = args[4].dval > rate ? args[4].dval : rate;
+    double duration = args[5].dval > 0.0 ? args[5].dval : 5.0;
+
+    if (args[0].sval == nullptr) {
+        errlogPrintf("missing argument #1 (instance name)\n");
+        return;
+    }
+    if (args[1].sval && !FFTWLoad::parse(args[1].sval, signal)) {
+        errlogPrintf("invalid argument #2 (signal) '%s'\n", args[1].sval);
+        return;
+    }
+
+    FFTWLoad load(signal, static_cast<size_t>(npoints));
+    if (strcmp(args[0].sval, "*") == 0) {
+        if (!load.addAll()) {
+            errlogPrintf("no instance is triggered by an input record\n");
+            return;
+        }
+    } else {
+        auto instance = FFTWInstance::find(args[0].sval);
+        if (instance == nullptr) {
+            errlogPrintf("'%s' no such instance\n", args[0].sval);
+            return;
+        }
+        if (!load.add(instance)) {
+            errlogPrintf("'%s' is not triggered by an input record\n", args[0].sval);
+            return;
+        }
+    }
+    load.run(rate, maxrate, duration);
+}
+
 static void
 fftwIocshRegister()
 {
     iocshRegister(&fftwShowFuncDef, fftwShowCallFunc);
+    iocshRegister(&fftwReportFuncDef, fftwReportCallFunc);
+    iocshRegister(&fftwTraceFuncDef, fftwTraceCallFunc);
+    iocshRegister(&fftwTraceDumpFuncDef, fftwTraceDumpCallFunc);
+    iocshRegister(&fftwPerfFuncDef, fftwPerfCallFunc);
+    iocshRegister(&fftwLoadFuncDef, fftwLoadCallFunc);
 }
 
 extern "C" {
@@ -14,6 +14,35 @@ dbLoadRecords("../../db/single.db","P=A1,R=:,TIME_N=128,FREQ_N=65")
 dbLoadRecords("../../db/single.db","P=A2,R=:,TIME_N=1024,FREQ_N=513")
 
 dbLoadRecords("../../db/single_asub.db","P=A3,R=:,TIME_N=1024,FREQ_N=513")
+dbLoadRecords("../../db/multi_asub.db","P=A4,R=:,TIME_N=1024,FREQ_N=513")
+dbLoadRecords("../../db/sliding.db","P=A5,R=:,TIME_N=64,LEN=128,BINS=3\\,10,BINS_N=2")
+dbLoadRecords("../../db/cross.db","P=A6,R=:,TIME_N=256,FREQ_N=129,CORR_N=511,AVG=8")
+dbLoadRecords("../../db/hilbert.db","P=A7,R=:,TIME_N=256")
+dbLoadRecords("../../db/order.db","P=A8,R=:,TIME_N=2048,SPR=32,FREQ_N=17")
+dbLoadRecords("../../db/dct.db","P=A9,R=:,TIME_N=64,KIND=dct2")
+dbLoadRecords("../../db/image.db","P=A10,R=:,ROWS=16,COLS=24,TIME_N=384,FREQ_N=208")
+dbLoadRecords("../../db/small.db","P=A11,R=:,TIME_N=8,FREQ_N=5,SMALL=y")
+dbLoadRecords("../../db/small.db","P=A12,R=:,TIME_N=16,FREQ_N=9,SMALL=y")
+dbLoadRecords("../../db/small.db","P=A13,R=:,TIME_N=32,FREQ_N=17,SMALL=y")
+dbLoadRecords("../../db/small.db","P=A14,R=:,TIME_N=64,FREQ_N=33,SMALL=y")
+dbLoadRecords("../../db/small.db","P=A15,R=:,TIME_N=8,FREQ_N=5,SMALL=n")
+dbLoadRecords("../../db/small.db","P=A16,R=:,TIME_N=16,FREQ_N=9,SMALL=n")
+dbLoadRecords("../../db/small.db","P=A17,R=:,TIME_N=32,FREQ_N=17,SMALL=n")
+dbLoadRecords("../../db/small.db","P=A18,R=:,TIME_N=64,FREQ_N=33,SMALL=n")
+dbLoadRecords("../../db/group.db","P=A19,R=:,TIME_N=256,FREQ_N=129,GROUP=G1,INPLACE=n")
+dbLoadRecords("../../db/group.db","P=A20,R=:,TIME_N=256,FREQ_N=129,GROUP=G1,INPLACE=n")
+dbLoadRecords("../../db/group.db","P=A21,R=:,TIME_N=256,FREQ_N=129,GROUP=G1,INPLACE=y")
+dbLoadRecords("../../db/inplace.db","P=A22,R=:,TIME_N=1000,FREQ_N=501,INPLACE=y")
+dbLoadRecords("../../db/inplace.db","P=A23,R=:,TIME_N=1000,FREQ_N=501,INPLACE=n")
+dbLoadRecords("../../db/zoom.db","P=A24,R=:,TIME_N=4096,CENTER=101,SPAN=4,BINS_N=400")
+dbLoadRecords("../../db/fsample.db","P=A24,R=:,FSAMP=1e3")
+dbLoadRecords("../../db/zoom.db","P=A25,R=:,TIME_N=4096,CENTER=101,SPAN=4,BINS_N=400")
+dbLoadRecords("../../db/decimate.db","P=A26,R=:,TIME_N=1024,DECIM=4,MIX=200,FREQ_N=129")
+dbLoadRecords("../../db/fsample.db","P=A26,R=:,FSAMP=1e3")
+dbLoadRecords("../../db/peaks.db","P=A27,R=:,TIME_N=1024,PEAKS=2")
+dbLoadRecords("../../db/fsample.db","P=A27,R=:,FSAMP=1e3")
+dbLoadRecords("../../db/reduce.db","P=A28,R=:,TIME_N=4096,FREQ_N=2049,LIN=64,LOG=32")
+dbLoadRecords("../../db/fsample.db","P=A28,R=:,FSAMP=8e3")
 
 iocInit()
 
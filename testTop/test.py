@@ -7,6 +7,26 @@ from epics import PV
 
 class TestFFTW(unittest.TestCase):
 
+    def monitor(self, names):
+        """
+        Connect to output PVs and wait for their first values.
+        Returns a function that waits until all of them have been updated again.
+        """
+        is_in = set()
+
+        def data_callback(pvname=None, **kwargs):
+            is_in.add(pvname)
+
+        outs = [PV(name, callback=data_callback) for name in names]
+
+        def wait():
+            while len(is_in) < len(outs):
+                time.sleep(0.001)
+            is_in.clear()
+
+        wait()
+        return wait
+
     def test_4e_pulse(self):
         """
         Test a 4 element array with a pulse
@@ -113,5 +133,338 @@ class TestFFTW(unittest.TestCase):
         self.assertTrue(np.allclose(result.imag, outi.get()))
         self.assertTrue(np.allclose(result.real, outr.get()))
 
+    def test_1ke_asub_2ch(self):
+        """
+        Test two 1k channels with different sine waves - using aSub
+        """
+        data0 = np.cos(2 * np.pi * np.arange(1024) / 1024)
+        data1 = np.cos(4 * 2 * np.pi * np.arange(1024) / 1024) + 0.5
+        wintype = PV('A4:wintype')
+        inp0 = PV('A4:inp-real0')
+        inp1 = PV('A4:inp-real1')
+        wait = self.monitor(['A4:out-' + part + ch for ch in ('0', '1') for part in ('real', 'imag')])
+
+        wintype.put('None', wait=True)
+        inp0.put(data0, wait=True)
+        inp1.put(data1, wait=True)
+        wait()
+
+        for ch, data in (('0', data0), ('1', data1)):
+            result = np.fft.rfft(data)
+            self.assertTrue(np.allclose(result.real, PV('A4:out-real' + ch).get()))
+            self.assertTrue(np.allclose(result.imag, PV('A4:out-imag' + ch).get()))
+
+    def test_sliding_2bins(self):
+        """
+        Test the sliding DFT of two 64 element blocks at two bins
+        """
+        data = np.cos(3 * 2 * np.pi * np.arange(128) / 128) + 0.3 * np.sin(10 * 2 * np.pi * np.arange(128) / 128)
+        inp = PV('A5:inp-real')
+        wait = self.monitor(['A5:out-real', 'A5:out-imag'])
+
+        for block in (data[:64], data[64:]):
+            inp.put(block, wait=True)
+            wait()
+
+        result = np.fft.rfft(data)[[3, 10]]
+        self.assertTrue(np.allclose(result.real, PV('A5:out-real').get()))
+        self.assertTrue(np.allclose(result.imag, PV('A5:out-imag').get()))
+        self.assertTrue(np.allclose([3 * 1e3 / 128, 10 * 1e3 / 128], PV('A5:fscale').get()))
+
+    def test_cross_gain(self):
+        """
+        Test coherence and H1 transfer function of a scaled, delayed and noisy copy, averaged over 8 frames
+        """
+        wait = self.monitor(['A6:coherence', 'A6:h1-magn', 'A6:h1-phas'])
+
+        # 255 samples: the new input size restarts the average
+        rng = np.random.default_rng(1)
+        gxx = gyy = gxy = 0
+        for frame in range(8):
+            data = rng.standard_normal(255)
+            resp = 0.5 * np.roll(data, 1) + 0.2 * rng.standard_normal(255)
+            PV('A6:inp-ref').put(data, wait=True)
+            PV('A6:inp-resp').put(resp, wait=True)
+            wait()
+            x, y = np.fft.rfft(data), np.fft.rfft(resp)
+            gxx = gxx + np.abs(x) ** 2 / 8
+            gyy = gyy + np.abs(y) ** 2 / 8
+            gxy = gxy + np.conj(x) * y / 8
+
+        coherence = np.abs(gxy) ** 2 / (gxx * gyy)
+        self.assertTrue(np.allclose(coherence, PV('A6:coherence').get()))
+        self.assertLess(np.mean(PV('A6:coherence').get()), 0.95)
+        self.assertTrue(np.allclose(np.abs(gxy / gxx), PV('A6:h1-magn').get()))
+        self.assertTrue(np.allclose(np.angle(gxy / gxx), PV('A6:h1-phas').get()))
+
+    def test_corr_delay(self):
+        """
+        Test cross correlation and delay estimation of a delayed pulse
+        """
+        t = np.arange(256)
+        data = np.exp(-((t - 100) / 8.) ** 2)
+        resp = np.exp(-((t - 105) / 8.) ** 2)
+        wait = self.monitor(['A6:corr', 'A6:delay'])
+
+        PV('A6:inp-ref').put(data, wait=True)
+        PV('A6:inp-resp').put(resp, wait=True)
+        wait()
+
+        self.assertTrue(np.allclose(np.correlate(resp, data, mode='full'), PV('A6:corr').get()))
+        self.assertAlmostEqual(5e-3, PV('A6:delay').get(), places=5)
+
+    def test_analytic_am(self):
+        """
+        Test envelope and instantaneous frequency of an amplitude modulated carrier
+        """
+        t = np.arange(256)
+        env = 1 + 0.5 * np.cos(3 * 2 * np.pi * t / 256)
+        data = env * np.cos(40 * 2 * np.pi * t / 256)
+        wait = self.monitor(['A7:envelope', 'A7:iphase', 'A7:ifreq'])
+
+        PV('A7:inp-real').put(data, wait=True)
+        wait()
+
+        self.assertTrue(np.allclose(env, PV('A7:envelope').get()))
+        self.assertTrue(np.allclose(40 * 2 * np.pi * t / 256, PV('A7:iphase').get()))
+        self.assertTrue(np.allclose(40 * 1e3 / 256, PV('A7:ifreq').get()))
+
+    def test_order_drifting_speed(self):
+        """
+        Test the order spectrum of a waveform with drifting speed
+        """
+        # 20 rev/s rising to 28 rev/s, order 3 and 7
+        angle = 0.1 + np.cumsum(20 + 0.004 * np.arange(2048)) / 1e3
+        data = np.cos(3 * 2 * np.pi * angle) + 0.5 * np.cos(7 * 2 * np.pi * angle)
+        tach = np.where(np.mod(angle, 1.0) < 0.3, 5.0, 0.0)
+        wait = self.monitor(['A8:out-real', 'A8:out-imag', 'A8:fscale'])
+
+        PV('A8:inp-tach').put(tach, wait=True)
+        PV('A8:inp-real').put(data, wait=True)
+        wait()
+
+        magn = np.abs(PV('A8:out-real').get() + 1j * PV('A8:out-imag').get())
+        self.assertTrue(np.allclose(np.arange(17), PV('A8:fscale').get()))
+        self.assertEqual([3, 7], sorted(np.argsort(magn)[-2:]))
+        self.assertAlmostEqual(16.0, magn[3], delta=1.0)
+
+    def test_dct2_roundtrip(self):
+        """
+        Test DCT-II coefficients and their inverse
+        """
+        n = np.arange(64)
+        data = np.sin(0.3 * n) + 0.01 * n
+        wait = self.monitor(['A9:coef', 'A9:inverse'])
+
+        PV('A9:inp-real').put(data, wait=True)
+        wait()
+
+        dct = 2 * np.cos(np.pi * np.outer(n, 2 * n + 1) / 128) @ data
+        self.assertTrue(np.allclose(dct, PV('A9:coef').get()))
+        self.assertTrue(np.allclose(data, PV('A9:inverse').get()))
+
+    def test_image_2d(self):
+        """
+        Test the 2D transform of a 16 x 24 image and its profiles
+        """
+        image = np.random.default_rng(2).standard_normal((16, 24))
+        wait = self.monitor(['A10:' + part for part in ('out-real', 'out-imag', 'prof-rows', 'prof-cols')])
+
+        PV('A10:inp-real').put(image.ravel(), wait=True)
+        wait()
+
+        result = np.fft.rfft2(image)
+        full = np.abs(np.fft.fft2(image))
+        self.assertTrue(np.allclose(result.real.ravel(), PV('A10:out-real').get()))
+        self.assertTrue(np.allclose(result.imag.ravel(), PV('A10:out-imag').get()))
+        self.assertTrue(np.allclose(full.sum(axis=1), PV('A10:prof-rows').get()))
+        self.assertTrue(np.allclose(np.abs(result).sum(axis=0), PV('A10:prof-cols').get()[:13]))
+
+    def test_small_kernels(self):
+        """
+        Test 8 to 64 element transforms with and without the fixed-size kernels
+        """
+        sizes = (8, 16, 32, 64)
+        instances = ['A%d' % i for i in range(11, 19)]
+        wait = self.monitor([inst + ':out-' + part for inst in instances for part in ('real', 'imag')])
+
+        rng = np.random.default_rng(3)
+        data = {n: rng.standard_normal(n) for n in sizes}
+        for k, inst in enumerate(instances):
+            PV(inst + ':inp-real').put(data[sizes[k % 4]], wait=True)
+        wait()
+
+        for k, inst in enumerate(instances):
+            n = sizes[k % 4]
+            result = np.fft.rfft(data[n] * np.sin(np.pi * np.arange(n) / (n - 1)) ** 2)
+            self.assertTrue(np.allclose(result.real, PV(inst + ':out-real').get()))
+            self.assertTrue(np.allclose(result.imag, PV(inst + ':out-imag').get()))
+
+    def test_group_batch(self):
+        """
+        Test a group of three 256 element members, one of them in place (calculated alone)
+        """
+        instances = ('A19', 'A20', 'A21')
+        wait = self.monitor([inst + ':out-' + part for inst in instances for part in ('real', 'imag')])
+
+        rng = np.random.default_rng(4)
+        for cycle in range(2):
+            data = {inst: rng.standard_normal(256) for inst in instances}
+            for inst in instances:
+                PV(inst + ':inp-real').put(data[inst], wait=True)
+            wait()
+
+            for inst in instances:
+                result = np.fft.rfft(data[inst])
+                self.assertTrue(np.allclose(result.real, PV(inst + ':out-real').get()))
+                self.assertTrue(np.allclose(result.imag, PV(inst + ':out-imag').get()))
+
+    def test_inplace(self):
+        """
+        Test that the in-place transform matches the out-of-place one, also on a trigger without new input
+        """
+        instances = ('A22', 'A23')
+        wait = self.monitor([inst + ':out-' + part for inst in instances for part in ('real', 'imag')])
+
+        data = np.random.default_rng(5).standard_normal(1000)
+        for inst in instances:
+            PV(inst + ':inp-real').put(data, wait=True)
+            PV(inst + ':wintype').put('Hann', wait=True)
+        wait()
+
+        result = np.fft.rfft(data * np.sin(np.pi * np.arange(1000) / 999) ** 2)
+        for retrigger in (False, True):
+            if retrigger:
+                for inst in instances:
+                    PV(inst + ':wintype').put('Hann', wait=True)
+                wait()
+            for inst in instances:
+                self.assertTrue(np.allclose(result.real, PV(inst + ':out-real').get()))
+                self.assertTrue(np.allclose(result.imag, PV(inst + ':out-imag').get()))
+
+    def test_zoom_2lines(self):
+        """
+        Test the zoom transform of two lines 1.5 Hz apart in a 4 Hz band
+        """
+        t = np.arange(4096) / 1e3
+        data = np.cos(2 * np.pi * 100 * t) + 0.5 * np.sin(2 * np.pi * 101.5 * t)
+        wait = self.monitor(['A24:out-real', 'A24:out-imag', 'A24:fscale'])
+
+        PV('A24:inp-real').put(data, wait=True)
+        wait()
+
+        freqs = 99 + 0.01 * np.arange(400)
+        result = np.exp(-2j * np.pi * np.outer(freqs, t)) @ data
+        out = PV('A24:out-real').get() + 1j * PV('A24:out-imag').get()
+        self.assertTrue(np.allclose(freqs, PV('A24:fscale').get()))
+        self.assertTrue(np.allclose(result, out, atol=1e-6))
+
+        def peaks(spectrum):
+            magn = np.abs(spectrum)
+            found = [k for k in range(1, 399) if magn[k - 1] < magn[k] > magn[k + 1]]
+            return sorted(sorted(found, key=lambda k: magn[k])[-2:])
+
+        self.assertEqual(peaks(result), peaks(out))
+        self.assertTrue(np.allclose([100, 101.5], freqs[peaks(out)], atol=0.02))
+
+    def test_zoom_no_fsample(self):
+        """
+        Test that a zoom instance without sample frequency reports invalid outputs
+        """
+        wait = self.monitor(['A25:out-real'])
+
+        PV('A25:inp-real').put(np.ones(4096), wait=True)
+        wait()
+
+        self.assertEqual(2, PV('A25:out-real').get_with_metadata()['severity'])
+
+    def test_decimate_mix(self):
+        """
+        Test decimation by 4 with the band around 200 Hz mixed down, over two consecutive 1024 element blocks
+        """
+        # in band (137.5 Hz to 262.5 Hz, bin 80 of the decimated transform) and far outside
+        t = np.arange(2048) / 1e3
+        data = np.cos(2 * np.pi * 215.625 * t) + 0.5 * np.cos(2 * np.pi * 400 * t)
+        wait = self.monitor(['A26:out-real', 'A26:out-imag'])
+
+        # the filter state carries over, the second block has no start-up transient
+        for block in (data[:1024], data[1024:]):
+            PV('A26:inp-real').put(block, wait=True)
+            wait()
+
+        magn = np.abs(PV('A26:out-real').get() + 1j * PV('A26:out-imag').get())
+        self.assertTrue(np.allclose(137.5 + np.arange(129) * 250 / 256, PV('A26:fscale').get()))
+        self.assertEqual(80, np.argmax(magn))
+        self.assertAlmostEqual(128.0, magn[80], delta=0.5)
+        self.assertLess(np.max(np.delete(magn, 80)), 0.01 * magn[80])
+
+    def test_peaks_harmonics(self):
+        """
+        Test peak interpolation and THD of a Hann windowed sine between two bins with a 2nd harmonic at -40 dB
+        """
+        t = np.arange(1024) / 1e3
+        data = np.cos(2 * np.pi * 100.3 * t + 0.4) + 0.01 * np.cos(2 * np.pi * 200.6 * t)
+        figures = ('fund', 'thd', 'snr', 'sinad', 'enob')
+        wait = self.monitor(['A27:peak-' + q for q in ('freq', 'ampl', 'phas')] + ['A27:harm-' + f for f in figures])
+
+        PV('A27:inp-real').put(data, wait=True)
+        wait()
+
+        # sub-bin frequency (bin spacing ~1 Hz), amplitude corrected with 2 / sum of the window
+        wsum = np.sum(np.sin(np.pi * np.arange(1024) / 1023) ** 2)
+        spectrum = np.fft.rfft(data * np.sin(np.pi * np.arange(1024) / 1023) ** 2)
+        freq, ampl = PV('A27:peak-freq').get(), PV('A27:peak-ampl').get()
+        self.assertTrue(np.allclose([100.3, 200.6], freq, atol=0.1))
+        self.assertTrue(np.allclose([1.0, 0.01], ampl, rtol=0.05))
+        # (the interpolated peak lies above the largest bin)
+        self.assertLessEqual(2 / wsum * np.max(np.abs(spectrum)), ampl[0])
+        self.assertAlmostEqual(freq[0], PV('A27:harm-fund').get())
+        self.assertAlmostEqual(-40.0, PV('A27:harm-thd').get(), delta=0.1)
+        self.assertAlmostEqual((PV('A27:harm-sinad').get() - 1.76) / 6.02, PV('A27:harm-enob').get(), places=3)
+
+    def test_reduce(self):
+        """
+        Test the reduced magnitude and frequency scale outputs of a 4096 element spectrum (max:64, mean:log32, mean:oct3)
+        """
+        names = ('max', 'log', 'oct3')
+        wait = self.monitor(['A28:out-magn'] + ['A28:' + part + '-' + name for name in names
+                                                 for part in ('magn', 'fscale')])
+
+        t = np.arange(4096) / 8e3
+        data = np.cos(2 * np.pi * 1234.5 * t) + 0.01 * np.random.default_rng(6).standard_normal(4096)
+        PV('A28:inp-real').put(data, wait=True)
+        wait()
+
+        magn = PV('A28:out-magn').get()
+        fscale = np.arange(2049) * 8e3 / 4096
+        # band tables as in FFTWReduce: [begin, end) of each band and its center
+        bands = {'max': [(j * 2049 // 64, (j + 1) * 2049 // 64) for j in range(64)]}
+        centers = {'max': [0.5 * (fscale[b] + fscale[e - 1]) for b, e in bands['max']]}
+        fmin, fmax = fscale[1], fscale[-1] + 0.5 * (fscale[-1] - fscale[-2])
+        edges, ratio, flo = [], (fmax / fmin) ** (1 / 32), fmin
+        for j in range(32):
+            fhi = fmax if j == 31 else flo * ratio
+            edges.append((flo, fhi, np.sqrt(flo * fhi)))
+            flo = fhi
+        edges = {'log': edges, 'oct3': []}
+        half = 2 ** (0.5 / 3)
+        for k in range(int(np.floor(3 * np.log2(fmin / 1e3))), int(np.ceil(3 * np.log2(fmax / 1e3))) + 1):
+            fc = 1e3 * 2 ** (k / 3)
+            edges['oct3'].append((max(fc / half, fmin), min(fc * half, fmax), fc))
+        for name in ('log', 'oct3'):
+            found = [(np.searchsorted(fscale, lo), np.searchsorted(fscale, hi), fc) for lo, hi, fc in edges[name]]
+            bands[name] = [(b, e) for b, e, fc in found if e > b]
+            centers[name] = [fc for b, e, fc in found if e > b]
+
+        for name in names:
+            self.assertEqual(len(bands[name]), len(PV('A28:magn-' + name).get()))
+            self.assertTrue(np.allclose(centers[name], PV('A28:fscale-' + name).get()))
+        self.assertTrue(np.allclose([np.max(magn[b:e]) for b, e in bands['max']], PV('A28:magn-max').get()))
+        for name in ('log', 'oct3'):
+            self.assertTrue(np.allclose([np.mean(magn[b:e]) for b, e in bands[name]], PV('A28:magn-' + name).get()))
+        # the line (bin 632) survives the max: reduction
+        self.assertEqual(np.max(magn), np.max(PV('A28:magn-max').get()))
+        self.assertEqual(632 * 64 // 2049, np.argmax(PV('A28:magn-max').get()))
+
 if __name__ == '__main__':
     unittest.main()